@@ -0,0 +1,81 @@
+#pragma once
+
+#include <bit>
+#include <bitset>
+#include <type_traits>
+
+
+// the same handful of bit operations over plain unsigned ints and std::bitset, so code that keeps
+// a set of flags can take the mask type as a template parameter and pick the narrowest that fits
+
+template<typename Mask>
+constexpr size_t maskWidth = sizeof(Mask) * 8;
+
+template<size_t N>
+constexpr size_t maskWidth<bitset<N>> = N;
+
+
+template<typename Mask>
+Mask maskBit(u32 i)
+{
+    if constexpr (is_integral_v<Mask>)
+        return Mask(Mask(1) << i);
+    else
+        return Mask().set(i);
+}
+
+// the lowest count bits set
+template<typename Mask>
+Mask lowBits(u32 count)
+{
+    if constexpr (is_integral_v<Mask>)
+        return count >= maskWidth<Mask> ? Mask(~Mask(0)) : Mask(maskBit<Mask>(count) - 1);
+    else
+        return count >= maskWidth<Mask> ? Mask().set() : ~(Mask().set() << count);
+}
+
+template<typename Mask>
+bool testBit(const Mask& mask, u32 i)
+{
+    if constexpr (is_integral_v<Mask>)
+        return (mask >> i) & 1;
+    else
+        return mask.test(i);
+}
+
+template<typename Mask>
+bool noBits(const Mask& mask)
+{
+    if constexpr (is_integral_v<Mask>)
+        return mask == 0;
+    else
+        return mask.none();
+}
+
+template<typename Mask>
+u32 countBits(const Mask& mask)
+{
+    if constexpr (is_integral_v<Mask>)
+        return u32(popcount(mask));
+    else
+        return u32(mask.count());
+}
+
+// calls fn(u32 i) for each set bit, lowest first
+template<typename Mask>
+void forEachBit(const Mask& mask, auto&& fn)
+{
+    if constexpr (is_integral_v<Mask>)
+    {
+        for (Mask m = mask; m; m &= m - 1)
+            fn(u32(countr_zero(m)));
+    }
+    else
+    {
+        for (u32 i = 0; i < maskWidth<Mask>; ++i)
+        {
+            if (mask.test(i))
+                fn(i);
+        }
+    }
+}
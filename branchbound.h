@@ -0,0 +1,260 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+
+// counters for one worker of a ParallelBranchAndBound run
+struct BranchStats
+{
+    u64 nodes = 0;          // search nodes the worker looked at
+    u64 pruned = 0;         // nodes thrown away because they couldn't beat the best so far
+    u32 tasks = 0;          // subtrees it searched
+    u32 stolen = 0;         // ...of which it took off another worker's queue
+    u32 improvements = 0;   // times it raised the shared best
+
+    BranchStats& operator+=(const BranchStats& other)
+    {
+        nodes += other.nodes;
+        pruned += other.pruned;
+        tasks += other.tasks;
+        stolen += other.stolen;
+        improvements += other.improvements;
+        return *this;
+    }
+};
+
+inline ostream& operator<<(ostream& os, const BranchStats& stats)
+{
+    return os << stats.nodes << " nodes, " << stats.pruned << " pruned, " << stats.tasks << " tasks ("
+        << stats.stolen << " stolen), " << stats.improvements << " improvements";
+}
+
+
+// maximising branch and bound spread over a pool of threads. the caller's search function gets a
+// task (a partial solution) and a Worker, and does its own depth first search from there:
+//   - worker.best() is the best score any thread has found so far, for pruning against
+//   - worker.offer(score) reports a complete solution
+//   - worker.shouldSplit(depth) says whether a child is worth handing out as a task of its own
+//     rather than being searched right away, in which case worker.spawn(child) queues it
+// every worker has its own queue, and ones that run dry steal the oldest (so usually biggest)
+// tasks from the others, or go to sleep until somebody spawns one. subtrees are split up eagerly
+// down to splitDepth, and past that only while somebody is sitting idle
+template<typename Task, typename Score = u32>
+class ParallelBranchAndBound
+{
+public:
+    class Worker
+    {
+    public:
+        Score best() const      { return m_pool.m_best.load(memory_order_relaxed); }
+
+        bool offer(Score score)
+        {
+            Score prev = m_pool.m_best.load(memory_order_relaxed);
+            while (score > prev)
+            {
+                if (m_pool.m_best.compare_exchange_weak(prev, score, memory_order_relaxed))
+                {
+                    ++m_stats.improvements;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool shouldSplit(u32 depth) const
+        {
+            return depth < m_pool.m_splitDepth || m_pool.m_idle.load(memory_order_relaxed) > 0;
+        }
+
+        void spawn(const Task& task)
+        {
+            m_pool.m_pending.fetch_add(1, memory_order_relaxed);
+            {
+                lock_guard lock(m_pool.m_queues[m_index].guard);
+                m_pool.m_queues[m_index].tasks.push_back(task);
+                m_pool.m_queued.fetch_add(1);
+            }
+
+            // queued then idle here, idle then queued in work(), so one side always sees the other
+            if (m_pool.m_idle.load() > 0)
+            {
+                lock_guard lock(m_pool.m_sleepGuard);
+                m_pool.m_wake.notify_one();
+            }
+        }
+
+        void visit()            { ++m_stats.nodes; }
+        void prune()            { ++m_stats.pruned; }
+
+        u32 index() const       { return m_index; }
+        const BranchStats& stats() const { return m_stats; }
+
+    private:
+        friend class ParallelBranchAndBound;
+
+        Worker(ParallelBranchAndBound& pool, u32 index) : m_pool(pool), m_index(index) {}
+
+        ParallelBranchAndBound& m_pool;
+        u32 m_index;
+        BranchStats m_stats;
+    };
+
+    explicit ParallelBranchAndBound(u32 numWorkers = thread::hardware_concurrency(), u32 splitDepth = 2)
+        : m_queues(max(numWorkers, 1u))
+        , m_splitDepth(splitDepth)
+    {
+    }
+
+    // searches everything under roots, and returns the best score offered (or initialBest if
+    // nothing beat it). search(const Task&, Worker&) is called once per task
+    template<typename Search>
+    Score run(span<const Task> roots, const Search& search, Score initialBest = {})
+    {
+        const u32 numWorkers = u32(m_queues.size());
+
+        m_best.store(initialBest);
+        m_idle.store(0);
+        m_pending.store(roots.size());
+        m_queued.store(roots.size());
+        for (size_t i = 0; i < roots.size(); ++i)
+            m_queues[i % numWorkers].tasks.push_back(roots[i]);
+
+        vector<Worker> workers;
+        workers.reserve(numWorkers);
+        for (u32 i = 0; i < numWorkers; ++i)
+            workers.push_back(Worker(*this, i));
+
+        // the calling thread is worker 0
+        vector<thread> threads;
+        threads.reserve(numWorkers - 1);
+        for (u32 i = 1; i < numWorkers; ++i)
+            threads.emplace_back([this, &search, &worker = workers[i]]() { work(worker, search); });
+
+        work(workers[0], search);
+        for (auto& t : threads)
+            t.join();
+
+        m_stats.clear();
+        for (auto& worker : workers)
+            m_stats.push_back(worker.m_stats);
+
+        return m_best.load();
+    }
+
+    // per-worker counters from the last run
+    span<const BranchStats> stats() const   { return m_stats; }
+
+    BranchStats totalStats() const
+    {
+        BranchStats total;
+        for (auto& s : m_stats)
+            total += s;
+        return total;
+    }
+
+private:
+    static constexpr size_t CacheLine = 64;
+
+    struct alignas(CacheLine) TaskQueue
+    {
+        mutex guard;
+        deque<Task> tasks;
+    };
+
+    template<typename Search>
+    void work(Worker& worker, const Search& search)
+    {
+        for (;;)
+        {
+            if (optional<Task> task = findTask(worker))
+            {
+                ++worker.m_stats.tasks;
+                search(*task, worker);
+
+                // the last task done, so wake everyone to go home
+                if (m_pending.fetch_sub(1) == 1)
+                {
+                    lock_guard lock(m_sleepGuard);
+                    m_wake.notify_all();
+                }
+                continue;
+            }
+
+            // nothing to steal: sleep until somebody queues a task or the whole search is done
+            m_idle.fetch_add(1);
+            {
+                unique_lock lock(m_sleepGuard);
+                m_wake.wait(lock, [this]() { return m_queued.load() > 0 || m_pending.load() == 0; });
+            }
+            m_idle.fetch_sub(1);
+
+            if (m_pending.load() == 0)
+                break;
+        }
+    }
+
+    optional<Task> findTask(Worker& worker)
+    {
+        if (auto task = popOwn(worker.m_index))
+            return task;
+
+        auto task = steal(worker.m_index);
+        if (task)
+            ++worker.m_stats.stolen;
+        return task;
+    }
+
+    // own queue is a stack, so a worker goes deep into what it's just split off...
+    optional<Task> popOwn(u32 index)
+    {
+        TaskQueue& queue = m_queues[index];
+        lock_guard lock(queue.guard);
+        if (queue.tasks.empty())
+            return nullopt;
+
+        Task task = move(queue.tasks.back());
+        queue.tasks.pop_back();
+        m_queued.fetch_sub(1);
+        return task;
+    }
+
+    // ...while thieves take from the other end, where the shallowest tasks are
+    optional<Task> steal(u32 thief)
+    {
+        const u32 numWorkers = u32(m_queues.size());
+        for (u32 i = 1; i < numWorkers; ++i)
+        {
+            TaskQueue& queue = m_queues[(thief + i) % numWorkers];
+            lock_guard lock(queue.guard);
+            if (queue.tasks.empty())
+                continue;
+
+            Task task = move(queue.tasks.front());
+            queue.tasks.pop_front();
+            m_queued.fetch_sub(1);
+            return task;
+        }
+        return nullopt;
+    }
+
+    vector<TaskQueue> m_queues;
+    u32 m_splitDepth;
+
+    alignas(CacheLine) atomic<Score> m_best{};
+    alignas(CacheLine) atomic<u32> m_idle{ 0 };
+    alignas(CacheLine) atomic<size_t> m_pending{ 0 };   // tasks queued or being searched
+    alignas(CacheLine) atomic<size_t> m_queued{ 0 };    // tasks sitting in a queue
+
+    mutex m_sleepGuard;
+    condition_variable m_wake;
+
+    vector<BranchStats> m_stats;
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <bit>
+#include <limits>
+#include <vector>
+
+
+// monotone priority queue (Dial's algorithm) for dense integer ids with small integer priorities,
+// which is exactly what shortest path searches with unit or small step costs need. priorities
+// must never go below the last one popped. buckets are a power-of-two ring indexed by priority,
+// so push, decrease_key and pop are all O(1) amortised; the ring doubles if a push lands further
+// ahead than it can reach
+template<typename Priority = u32>
+class bucket_queue
+{
+public:
+    using priority_type = Priority;
+    static_assert(is_integral_v<Priority>, "bucket queues need integer priorities");
+
+    explicit bucket_queue(size_t numIds = 0, u32 numBuckets = 64)
+        : m_buckets(bit_ceil(max(numBuckets, 2u)))
+        , m_mask(u32(m_buckets.size() - 1))
+    {
+        resize(numIds);
+    }
+
+    // ids can be anything in [0, numIds)
+    void resize(size_t numIds)
+    {
+        m_slot.resize(numIds, NotQueued);
+        m_priority.resize(numIds);
+    }
+
+    void clear()
+    {
+        for (auto& bucket : m_buckets)
+        {
+            for (u32 id : bucket)
+                m_slot[id] = NotQueued;
+            bucket.clear();
+        }
+        m_size = 0;
+        m_current = 0;
+    }
+
+    [[nodiscard]] bool empty() const            { return m_size == 0; }
+    [[nodiscard]] size_t size() const           { return m_size; }
+    [[nodiscard]] bool contains(u32 id) const   { return m_slot[id] != NotQueued; }
+    [[nodiscard]] Priority priority(u32 id) const { return m_priority[id]; }
+
+    void push(u32 id, Priority p)
+    {
+#ifdef _DEBUG
+        if (contains(id) || p < m_current)
+            throw "bad bucket_queue push";
+#endif
+        if (u64(p - m_current) > m_mask)
+            regrow(u64(p - m_current) + 1);
+
+        insert(id, p);
+        ++m_size;
+    }
+
+    void decrease_key(u32 id, Priority p)
+    {
+        remove(id);
+        insert(id, p);
+    }
+
+    // the usual relax step: queue id at p, or move it down to p if it's already queued higher
+    void push_or_decrease(u32 id, Priority p)
+    {
+        if (!contains(id))
+            push(id, p);
+        else if (p < m_priority[id])
+            decrease_key(id, p);
+    }
+
+    // removes and returns the id with the lowest priority
+    u32 pop()
+    {
+        if (empty())
+            throw "pop from empty bucket queue";
+
+        auto* bucket = &m_buckets[m_current & m_mask];
+        while (bucket->empty())
+        {
+            ++m_current;
+            bucket = &m_buckets[m_current & m_mask];
+        }
+
+        u32 id = bucket->back();
+        bucket->pop_back();
+        m_slot[id] = NotQueued;
+        --m_size;
+        return id;
+    }
+
+    // same, but picks among the ids tied on the lowest priority with better(u32 a, u32 b) rather
+    // than taking the last one pushed. looks at every id in the bucket, so it costs more
+    u32 pop(auto&& better)
+    {
+        if (empty())
+            throw "pop from empty bucket queue";
+
+        while (m_buckets[m_current & m_mask].empty())
+            ++m_current;
+
+        const auto& bucket = m_buckets[m_current & m_mask];
+        u32 id = bucket.back();
+        for (u32 other : bucket)
+        {
+            if (better(other, id))
+                id = other;
+        }
+
+        remove(id);
+        --m_size;
+        return id;
+    }
+
+private:
+    static constexpr u32 NotQueued = numeric_limits<u32>::max();
+
+    void insert(u32 id, Priority p)
+    {
+        auto& bucket = m_buckets[u32(p) & m_mask];
+        m_priority[id] = p;
+        m_slot[id] = u32(bucket.size());
+        bucket.push_back(id);
+    }
+
+    void remove(u32 id)
+    {
+        auto& bucket = m_buckets[u32(m_priority[id]) & m_mask];
+        const u32 slot = m_slot[id];
+        bucket[slot] = bucket.back();
+        m_slot[bucket[slot]] = slot;
+        bucket.pop_back();
+        m_slot[id] = NotQueued;
+    }
+
+    void regrow(u64 reach)
+    {
+        vector<vector<u32>> old(bit_ceil(reach));
+        old.swap(m_buckets);
+        m_mask = u32(m_buckets.size() - 1);
+
+        for (auto& bucket : old)
+        {
+            for (u32 id : bucket)
+                insert(id, m_priority[id]);
+        }
+    }
+
+    vector<vector<u32>> m_buckets;
+    vector<u32> m_slot;             // where each id sits in its bucket
+    vector<Priority> m_priority;
+    u32 m_mask;
+    size_t m_size = 0;
+    Priority m_current = 0;         // nothing queued is lower than this
+};
@@ -11,7 +11,7 @@ using namespace std;
 using CharGrid = vector<string>;
 
 
-ostream& operator<<(ostream& os, const CharGrid& grid)
+inline ostream& operator<<(ostream& os, const CharGrid& grid)
 {
     for (const auto& row : grid)
         os << row << '\n';
@@ -26,36 +26,146 @@ inline string get_column(size_t ix, const CharGrid& grid)
     return column;
 }
 
-inline CharGrid rotate(const CharGrid& grid, uint32_t turns_anticlockwise)
+// a CharGrid seen rotated and/or flipped without copying anything: view coords are just
+// remapped onto the underlying grid with a little affine transform
+class CharGridView
 {
-    CharGrid rotated;
+public:
+    explicit CharGridView(const CharGrid& grid, uint32_t turns_anticlockwise = 0)
+        : m_grid(&grid)
+        , m_width(grid.empty() ? 0 : grid.front().size())
+        , m_height(grid.size())
+    {
+        for (uint32_t turn = 0; turn < (turns_anticlockwise & 0x03); ++turn)
+            *this = rotated();
+    }
+
+    [[nodiscard]] size_t width() const  { return m_width; }
+    [[nodiscard]] size_t height() const { return m_height; }
+
+    char operator()(size_t x, size_t y) const
+    {
+        auto [sx, sy] = source(x, y);
+        return (*m_grid)[sy][sx];
+    }
+
+    // where (x,y) in the view lives in the underlying grid
+    pair<size_t, size_t> source(size_t x, size_t y) const
+    {
+        const int64_t ix = int64_t(x);
+        const int64_t iy = int64_t(y);
+        return { size_t(m_ox + m_xx * ix + m_xy * iy), size_t(m_oy + m_yx * ix + m_yy * iy) };
+    }
 
-    switch (turns_anticlockwise & 0x03)
+    // one turn anticlockwise: view(x,y) = this(w-1-y, x)
+    [[nodiscard]] CharGridView rotated() const
     {
-    case 0:
-        copy(grid.begin(), grid.end(), back_inserter(rotated));
-        break;
-
-    case 1:
-        for (size_t col = grid.front().size() - 1; col < grid.front().size(); --col)
-            rotated.emplace_back(get_column(col, grid));
-        break;
-
-    case 2:
-        for (auto itrow = grid.rbegin(); itrow != grid.rend(); ++itrow)
-            rotated.emplace_back(itrow->rbegin(), itrow->rend());
-        break;
-
-    case 3:
-        for (size_t col = 0; col < grid.front().size(); ++col)
+        return remapped(int64_t(m_width) - 1, 0, -1, 0, 1, 0, m_height, m_width);
+    }
+    // view(x,y) = this(w-1-x, y)
+    [[nodiscard]] CharGridView hflipped() const
+    {
+        return remapped(int64_t(m_width) - 1, -1, 0, 0, 0, 1, m_width, m_height);
+    }
+    // view(x,y) = this(x, h-1-y)
+    [[nodiscard]] CharGridView vflipped() const
+    {
+        return remapped(0, 1, 0, int64_t(m_height) - 1, 0, -1, m_width, m_height);
+    }
+
+    // rows of the view run along rows of the source, possibly backwards
+    [[nodiscard]] bool isTransposed() const { return m_xy != 0 || m_yx != 0; }
+
+    string row(size_t y) const
+    {
+        string r(m_width, '.');
+        if (!isTransposed())
         {
-            string c = get_column(col, grid);
-            rotated.emplace_back(c.rbegin(), c.rend());
+            copyRow(y, r.data());
+            return r;
         }
-        break;
+
+        for (size_t x = 0; x < m_width; ++x)
+            r[x] = (*this)(x, y);
+        return r;
     }
 
-    return rotated;
+    // copy out into a real grid. when the rows aren't transposed every view row is one run of a
+    // source row, forwards or backwards. otherwise we go tile by tile so that both the rows we
+    // read and the rows we write stay in cache
+    CharGrid materialise() const
+    {
+        CharGrid out(m_height, string(m_width, '.'));
+        if (!isTransposed())
+        {
+            for (size_t y = 0; y < m_height; ++y)
+                copyRow(y, out[y].data());
+            return out;
+        }
+
+        constexpr size_t Tile = 64;
+        for (size_t ty = 0; ty < m_height; ty += Tile)
+        {
+            const size_t yEnd = min(ty + Tile, m_height);
+            for (size_t tx = 0; tx < m_width; tx += Tile)
+            {
+                const size_t xEnd = min(tx + Tile, m_width);
+                for (size_t y = ty; y < yEnd; ++y)
+                {
+                    char* dst = out[y].data();
+                    for (size_t x = tx; x < xEnd; ++x)
+                        dst[x] = (*this)(x, y);
+                }
+            }
+        }
+        return out;
+    }
+
+private:
+    // view row y of an untransposed view, straight out of its source row
+    void copyRow(size_t y, char* dst) const
+    {
+        if (m_width == 0)
+            return;
+
+        auto [sx, sy] = source(0, y);
+        const char* src = (*m_grid)[sy].data() + sx;
+        if (m_xx > 0)
+            copy_n(src, m_width, dst);
+        else
+            reverse_copy(src - (m_width - 1), src + 1, dst);
+    }
+
+    // builds a view whose coords (x,y) map to this view's (ox + xx*x + xy*y, oy + yx*x + yy*y)
+    CharGridView remapped(int64_t ox, int64_t xx, int64_t xy, int64_t oy, int64_t yx, int64_t yy, size_t width, size_t height) const
+    {
+        CharGridView v = *this;
+        v.m_ox = m_ox + m_xx * ox + m_xy * oy;
+        v.m_oy = m_oy + m_yx * ox + m_yy * oy;
+        v.m_xx = m_xx * xx + m_xy * yx;
+        v.m_xy = m_xx * xy + m_xy * yy;
+        v.m_yx = m_yx * xx + m_yy * yx;
+        v.m_yy = m_yx * xy + m_yy * yy;
+        v.m_width = width;
+        v.m_height = height;
+        return v;
+    }
+
+    const CharGrid* m_grid;
+    size_t m_width;
+    size_t m_height;
+
+    int64_t m_ox = 0, m_xx = 1, m_xy = 0;
+    int64_t m_oy = 0, m_yx = 0, m_yy = 1;
+};
+
+
+inline CharGrid rotate(const CharGrid& grid, uint32_t turns_anticlockwise)
+{
+    if ((turns_anticlockwise & 0x03) == 0)
+        return grid;
+
+    return CharGridView(grid, turns_anticlockwise).materialise();
 }
 
 inline void vflip(CharGrid& grid)
@@ -1,66 +1,16 @@
 ﻿#include "pch.h"
 #include "harness.h"
 
-#define CHECKED_RINGBUFFERx
-
-
-template<typename T, size_t N>
-class fixed_ring_buffer
-{
-public:
-    using value_type = T;
-    static constexpr size_t capacity = N;
-
-    const value_type& front() const
-    {
-#ifdef CHECKED_RINGBUFFER
-        if (m_front == m_back) [[unlikely]]
-            throw "can't read from an empty ringbuf";
-#endif
-
-        return m_buf[m_front];
-    }
-
-    [[nodiscard]] bool empty() const
-    {
-        return m_front == m_back;
-    }
-
-
-    void push_back(const value_type& val)
-    {
-#ifdef CHECKED_RINGBUFFER
-        if (m_front == ((m_back + 1) % capacity)) [[unlikely]]
-            throw "can't push onto a full ringbuf";
-#endif
-
-        m_buf[m_back] = val;
-        m_back = (m_back + 1) % capacity;
-    }
-
-    void pop_front()
-    {
-#ifdef CHECKED_RINGBUFFER
-        if (m_front == m_back) [[unlikely]]
-            throw "can't pop from an empty ringbuf";
-#endif
-
-        m_front = (m_front + 1) % capacity;
-    }
-
-private:
-    value_type m_buf[capacity];
-    u32 m_back = 0;
-    u32 m_front = 0;
-};
+#include "ringbuffer.h"
 
+#include <thread>
 
 
 struct Monkey
 {
     static Monkey parse(stringlist::const_iterator& itLine, stringlist::const_iterator itEnd);
 
-    fixed_ring_buffer<i64, 128> items;
+    ring_buffer<i64> items;
     u32 business = 0;
 
     int id = -1;
@@ -201,8 +151,89 @@ i64 day11_2(const stringlist& input)
 }
 
 
+// pushes count numbered items through a small fixed ring, a few at a time and a bunch at a time,
+// so it wraps and fills up over and over; returns how many came back out in order
+u32 cycleFixedRing(u32 count)
+{
+    fixed_ring_buffer<u32, 8> ring;
+    array<u32, 5> in, out;
+    u32 pushed = 0, popped = 0;
+    for (u32 round = 0; popped < count; ++round)
+    {
+        if (round % 2)
+        {
+            const u32 n = min(count - pushed, u32(1 + round % in.size()));
+            iota(begin(in), begin(in) + n, pushed);
+            pushed += u32(ring.push_back(span<const u32>(in.data(), n)));
+        }
+        else
+        {
+            while (pushed < count && !ring.full())
+                ring.push_back(pushed++);
+
+            if (pushed < count && ring.push_back(span<const u32>(in.data(), 1)) != 0)
+                throw "pushed onto a full ring";
+        }
+
+        const size_t got = ring.pop_front(span(out).first(1 + round % 3));
+        for (size_t i = 0; i < got; ++i)
+        {
+            if (out[i] != popped++)
+                throw "fixed ring lost or reordered items";
+        }
+    }
+
+    if (!ring.empty())
+        throw "fixed ring has leftovers";
+    return popped;
+}
+
+// one thread pushes count numbered items through a small spsc ring while this one pops them, in
+// uneven batches on each side; returns how many came out in order
+u32 streamSpscRing(u32 count)
+{
+    spsc_ring_buffer<u32, 64> ring;
+
+    thread producer([&ring, count]()
+    {
+        array<u32, 7> batch;
+        for (u32 next = 0; next < count; )
+        {
+            const u32 n = min(count - next, u32(batch.size()));
+            iota(begin(batch), begin(batch) + n, next);
+
+            const u32 pushed = u32(ring.try_push(span<const u32>(batch.data(), n)));
+            next += pushed;
+            if (pushed < n)
+                this_thread::yield();
+        }
+    });
+
+    array<u32, 5> out;
+    u32 expected = 0;
+    bool inOrder = true;
+    while (expected < count)
+    {
+        const size_t got = ring.try_pop(span(out));
+        for (size_t i = 0; i < got; ++i)
+            inOrder &= (out[i] == expected++);
+
+        if (got == 0)
+            this_thread::yield();
+    }
+    producer.join();
+
+    if (!inOrder || ring.size_approx() != 0)
+        throw "spsc ring lost or reordered items";
+    return expected;
+}
+
+
 void run_day11()
 {
+    test(1000u, cycleFixedRing(1000));
+    test(1000000u, streamSpscRing(1000000));
+
     test(10605, day11(LOAD(11t)));
     gogogo(day11(LOAD(11)));
 
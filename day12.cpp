@@ -2,105 +2,94 @@
 #include "harness.h"
 #include "pt2.h"
 #include "vector2d.h"
+#include "gridsearch.h"
 
-#include <queue>
+#include <random>
 
-namespace
-{
-using MapCoord = vector2d<char>::coord;
-using MapIndex = MapCoord;
-constexpr MapIndex InvalidMapIx(std::numeric_limits<MapCoord::el_type>::max(), std::numeric_limits<MapCoord::el_type>::max());
 
-using Distance = u16;
-constexpr Distance MaxDistance = numeric_limits<Distance>::max();
+using MapCoord = vector2d<char>::coord;
 
-constexpr MapCoord Directions[] = {{1,0}, {0,1}, {-1,0}, {0,-1}};
+// you can climb at most one step up, but jump down as far as you like
+auto canClimb(const auto& map)
+{
+    return [&map](const MapCoord& from, const MapCoord& to) { return map[to] <= map[from] + 1; };
 }
 
 
-int findShortestPath(const vector2d<char>& map, MapCoord start, MapCoord dest)
+int climbHill(auto&& map)
 {
-    vector2d<MapIndex> bestPath(map.width(), map.height(), InvalidMapIx);
-    vector2d<u8> visited(map.width(), map.height(), false);
-
-    using DistCoordPair = pair<Distance, MapCoord>;
-    using OpenSet = vector<DistCoordPair>;
-    OpenSet open;
+    auto start = map.find_first('S');
+    auto dest = map.find_first('E');
 
-    visited[start] = true;
-    open.emplace_back(Distance(0), start);
+    map[start] = 'a';
+    map[dest] = 'z';
 
-    bool found = false;
-    while (!open.empty() && !found)
-    {
-        auto nextIt = ranges::min_element(open, less<Distance>(), &DistCoordPair::first);
-        auto [nodeDist, nodePos] = *nextIt;
-        char node = map[nodePos];
-        erase_unsorted(open, nextIt);
-        visited[nodePos] = true;
-
-        for (const auto& dir : Directions)
-        {
-            MapCoord neighbourPos = nodePos + dir;
-            if (!map.isInMap(neighbourPos))
-                continue;
-
-            if (visited[neighbourPos])
-                continue;
-
-            char neighbour = map[neighbourPos];
-            if (neighbour > node + 1)
-                continue;
-
-            Distance newDist = nodeDist + 1;
-
-            if (neighbourPos == dest)
-            {
-                return int(newDist);
-            }
-
-            auto neighbourIt = ranges::find_if(open, [neighbourPos](auto& dcpair) { return dcpair.second == neighbourPos; });
-            if (neighbourIt != end(open))
-            {
-                if (neighbourIt->first > newDist)
-                {
-                    neighbourIt->first = newDist;
-                    bestPath[neighbourPos] = nodePos;
-                }
-            }
-            else
-            {
-                bestPath[neighbourPos] = nodePos;
-                open.emplace_back(newDist, neighbourPos);
-            }
-        }
-    }
-
-    // no path
-    return INT_MAX;
+    GridSearch search(map);
+    auto dist = search.findShortestPath(start, dest, canClimb(map));
+    return dist == search.Unreachable ? INT_MAX : int(dist);
 }
 
-
 int day12(const stringlist& input)
 {
-    vector2d<char> map(input);
-    if ((map.width()+1 >= u32(InvalidMapIx.x)) || (map.height() + 1 >= u32(InvalidMapIx.y)))
-        throw "too many cells!";
+    return climbHill(vector2d<char>(input));
+}
 
+// same climb, but steered towards the summit
+int climbHillAStar(const stringlist& input)
+{
+    vector2d<char> map(input);
     auto start = map.find_first('S');
     auto dest = map.find_first('E');
 
     map[start] = 'a';
     map[dest] = 'z';
 
-    return findShortestPath(map, start, dest);
+    GridSearch search(map);
+    auto dist = search.findShortestPathAStar(start, dest, canClimb(map));
+    return dist == search.Unreachable ? INT_MAX : int(dist);
+}
+
+// a big flat field with boulders dotted about, corner to corner, to see how much of it each
+// search has to look at. returns how many cells each expanded: dijkstra, a*, a* with ties going
+// to the lowest heuristic
+array<u32, 3> compareSearches(u32 size, int boulderPercent, u32 seed)
+{
+    vector2d<char> map(size, size, 'a');
+    mt19937 rng(seed);
+    uniform_int_distribution<int> percent(0, 99);
+    map.foreach_matching('a', [&](const MapCoord& c)
+    {
+        if (percent(rng) < boulderPercent)
+            map[c] = '~';       // far too high to climb onto
+    });
+
+    const MapCoord start{ 0, 0 };
+    const MapCoord dest{ i16(size - 1), i16(size - 1) };
+    map[start] = 'a';
+    map[dest] = 'a';
+
+    GridSearch search(map);
+    const auto dijkstraDist = search.findShortestPath(start, dest, canClimb(map));
+    const SearchStats dijkstra = search.stats();
+    const auto aStarDist = search.findShortestPathAStar(start, dest, canClimb(map));
+    const SearchStats aStar = search.stats();
+    const auto lowerHDist = search.findShortestPathAStar(start, dest, canClimb(map), ManhattanHeuristic{}, UnitStepCost{}, LowerHeuristicFirst{});
+    const SearchStats lowerH = search.stats();
+
+    if (aStarDist != dijkstraDist || lowerHDist != dijkstraDist)
+        throw "searches disagree on the distance";
+
+    cout << "  " << size << "x" << size << " field, distance " << dijkstraDist << endl;
+    cout << "    dijkstra:    " << dijkstra << endl;
+    cout << "    a*:          " << aStar << endl;
+    cout << "    a*, lower h: " << lowerH << endl;
+
+    return { dijkstra.expanded, aStar.expanded, lowerH.expanded };
 }
 
 int day12_2(const stringlist& input)
 {
     vector2d<char> hill(input);
-    if ((hill.width() + 1 >= u32(InvalidMapIx.x)) || (hill.height() + 1 >= u32(InvalidMapIx.y)))
-        throw "too many cells!";
 
     // all start points are equal
     auto start = hill.find_first('S');
@@ -112,11 +101,15 @@ int day12_2(const stringlist& input)
     auto dest = hill.find_first('E');
     hill[dest] = 'z';
 
-    int shortest = INT_MAX;
+    // one flood back downhill from the summit gives the distance from every start at once
+    GridSearch search(hill);
+    const auto& distToDest = search.findDistanceField(dest, reversed(canClimb(hill)));
+
+    auto shortest = search.Unreachable;
     for (auto& startPoint : startPoints)
-        shortest = min(shortest, findShortestPath(hill, startPoint, dest));
+        shortest = min(shortest, distToDest[startPoint]);
 
-    return shortest;
+    return shortest == search.Unreachable ? INT_MAX : int(shortest);
 }
 
 
@@ -130,8 +123,16 @@ acctuvwj
 abdefghi)";
 
     test(31, day12(READ(sample)));
+    test(31, climbHill(vector2d<char>(string_view(sample))));
+    test(330, climbHill(mapped_vector2d<char>(MAPFILE(12))));
+    test(31, climbHillAStar(READ(sample)));
+    test(330, climbHillAStar(LOAD(12)));
+    // thick enough with boulders for the tie-break to matter; on sparser fields last-pushed-first
+    // already is the lowest heuristic and the two expand exactly the same cells
+    auto [dijkstraExpanded, aStarExpanded, lowerHExpanded] = compareSearches(300, 30, 12);
+    test(true, aStarExpanded < dijkstraExpanded && lowerHExpanded < aStarExpanded);
     gogogo(day12(LOAD(12)));
 
     test(29, day12_2(READ(sample)));
-    nononoD(day12_2(LOAD(12)));
+    gogogo(day12_2(LOAD(12)), 321);
 }
\ No newline at end of file
@@ -1,10 +1,17 @@
 ﻿#include "pch.h"
 #include "harness.h"
 #include "pt2.h"
-#include "vector2d.h"
+#include "sparsegrid.h"
 
 
 using Pt = Pt2i16;
+using CaveMap = sparse_grid<char, i16>;
+
+struct Cave
+{
+    CaveMap map{ '.' };
+    i16 floorY = 0;     // two below the lowest rock
+};
 
 struct Barrier
 {
@@ -56,7 +63,7 @@ Pt calcRockStep(const Pt& start, const Pt& end)
     return { sign(diff.x), sign(diff.y) };
 }
 
-void addRocks(vector2d<char>& map, const Pt& start, const Pt& end)
+void addRocks(CaveMap& map, const Pt& start, const Pt& end)
 {
     Pt step = calcRockStep(start, end);
     for (Pt p = start; p != end; p += step)
@@ -66,96 +73,88 @@ void addRocks(vector2d<char>& map, const Pt& start, const Pt& end)
     map[end] = '#';
 }
 
-bool dropSand(vector2d<char>& map, const Pt& source)
+bool dropSand(Cave& cave, const Pt& source, bool abyss)
 {
     constexpr Pt dn{ 0,1 };
     constexpr Pt dl{ -1,1 };
     constexpr Pt dr{ 1,1 };
 
+    CaveMap& map = cave.map;
     auto s = source;
-    if (map[s] != '.' && map[s] != '+')
+    if (map.get(s) != '.' && map.get(s) != '+')
         return false;
 
     for (;;)
     {
-        auto next = s + dn;
-        if (next.y + 1 > int(map.height()))
-            return false;
+        // the floor is infinitely wide, so it never gets drawn into the map
+        if (s.y + 1 == cave.floorY)
+        {
+            if (abyss)
+                return false;
+
+            map[s] = 'o';
+            return true;
+        }
 
-        if (map[next] == '.')
+        auto next = s + dn;
+        if (map.get(next) == '.')
         {
             s = next;
             continue;
         }
 
         next = s + dl;
-        if (map[next] == '.')
+        if (map.get(next) == '.')
         {
             s = next;
             continue;
         }
 
         next = s + dr;
-        if (map[next] == '.')
+        if (map.get(next) == '.')
         {
             s = next;
             continue;
         }
 
-        if (map.isInMap(s))
-        {
-            map[s] = 'o';
-            return true;
-        }
+        map[s] = 'o';
+        return true;
     }
 }
 
 
 constexpr i16 SandSourceX = 500;
 
-vector2d<char> loadMap(const stringlist& input, bool abyss)
+Cave loadCave(const stringlist& input)
 {
-    TIME_SCOPE(loadMap);
-    vector<Barrier> barriers;
-    barriers.reserve(input.size());
-    ranges::transform(input, back_inserter(barriers), parseBarrier);
-
-    i16 maxy = -1;
-    for (const Barrier& b : barriers)
-        maxy = max(maxy, b.hi.y);
-
-    maxy += 2;
-
-    i16 minx = SandSourceX - maxy;
-    i16 maxx = SandSourceX + maxy;
-
-    vector2d<char> map(maxx - minx + 1, maxy + 1, '.');
-    map.setOffset({ minx, 0 });
+    TIME_SCOPE(loadCave);
 
-    for (const Barrier& b : barriers)
+    // no need to size anything up front: the map grows as the rocks go in
+    Cave cave;
+    for (const string& line : input)
     {
+        Barrier b = parseBarrier(line);
         for (auto itPoint = begin(b.points); (itPoint + 1) != end(b.points); ++itPoint)
-            addRocks(map, *itPoint, *(itPoint + 1));
+            addRocks(cave.map, *itPoint, *(itPoint + 1));
     }
 
-    if (!abyss)
-        addRocks(map, { minx, maxy }, { maxx, maxy });
+    cave.floorY = cave.map.hi().y + 2;
 
-    return map;
+    return cave;
 }
 
 
 int day14(const stringlist& input)
 {
-    vector2d<char> map = loadMap(input, true);
+    Cave cave = loadCave(input);
 
     auto source = Pt{ SandSourceX, 0 };
-    map[source] = '+';
+    cave.map[source] = '+';
 
     int restingSand = 0;
     for (;;)
     {
-        if (!dropSand(map, source))
+        if (!dropSand(cave, source, true))
             break;
 
         ++restingSand;
@@ -166,15 +165,15 @@ int day14(const stringlist& input)
 
 int day14_2(const stringlist& input)
 {
-    vector2d<char> map = loadMap(input, false);
+    Cave cave = loadCave(input);
 
     auto source = Pt{ SandSourceX, 0 };
-    map[source] = '+';
+    cave.map[source] = '+';
 
     int restingSand = 0;
     for (;;)
     {
-        if (!dropSand(map, source))
+        if (!dropSand(cave, source, false))
             break;
 
         ++restingSand;
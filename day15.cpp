@@ -1,154 +1,90 @@
 ﻿#include "pch.h"
 #include "harness.h"
 #include "pt2.h"
+#include "intervalset.h"
+#include "pointssoa.h"
 
 
-struct Report
+// sensors and their beacons are kept as structure-of-arrays so the per-row work is a batch kernel
+struct Sensors
 {
-    Pt2i s, b;
+    PointsSoA<Pt2i> pos;
+    PointsSoA<Pt2i> beacons;
+    vector<int> radius;     // manhattan distance from each sensor to its beacon
 };
 
-int manhattan(const Pt2i& a, const Pt2i& b)
+Sensors readSensors(const stringlist& input)
 {
-    return abs(a.x - b.x) + abs(a.y - b.y);
-}
-
-
-vector<Report> readReports(const stringlist& input)
-{
-    vector<Report> reports;
-    reports.reserve(input.size());
+    Sensors sensors;
+    sensors.pos.reserve(input.size());
+    sensors.beacons.reserve(input.size());
 
     for (auto& line : input)
     {
         istringstream is(line);
         Pt2i s, b;
         is >> "Sensor at x=" >> s.x >> ", y=" >> s.y >> ": closest beacon is at x=" >> b.x >> ", y=" >> b.y;
-        reports.emplace_back(s, b);
+        sensors.pos.push_back(s);
+        sensors.beacons.push_back(b);
     }
 
-    return reports;
+    sensors.radius.resize(sensors.pos.size());
+    sensors.pos.manhattanTo(sensors.beacons, span(sensors.radius));
+
+    return sensors;
 }
 
-auto intervalLess = [](const pair<int, int>& a, const pair<int, int>& b)
+// collects the x interval each sensor can see on row y
+void findCoverage(const Sensors& sensors, int y, vector<int>& rowDist, IntervalSet<int>& coverage)
 {
-    return a.first < b.first;
-};
-void coalesceIntervals(vector<pair<int, int>>& intervals)
-{
-    sort(begin(intervals), end(intervals), intervalLess);
+    const size_t numSensors = sensors.pos.size();
+    rowDist.resize(numSensors);
+    sensors.pos.distanceToRow(y, span(rowDist));
 
-    static vector<pair<int, int>> outervals;
-    outervals.clear();
-    outervals.push_back(intervals.front());
-    for (const auto& i : intervals)
+    coverage.clear();
+    const auto& xs = sensors.pos.xs();
+    for (size_t i = 0; i < numSensors; ++i)
     {
-        if (i.first <= outervals.back().second)
-        {
-            outervals.back().second = max(i.second, outervals.back().second);
+        int hSizeAtY = sensors.radius[i] - rowDist[i];
+        if (hSizeAtY < 0)
             continue;
-        }
 
-        outervals.push_back(i);
+        coverage.insert(xs[i] - hSizeAtY, xs[i] + hSizeAtY);
     }
-    outervals.swap(intervals);
 }
 
 
 int day15(const stringlist& input, int y)
 {
-    set<int> beaconsOnRow;
-    vector<pair<int, int>> intervals;
-    for (auto& line : input)
-    {
-        istringstream is(line);
-        Pt2i s, b;
-        is >> "Sensor at x=" >> s.x >> ", y=" >> s.y >> ": closest beacon is at x=" >> b.x >> ", y=" >> b.y;
-
-        if (b.y == y)
-            beaconsOnRow.insert(b.x);
-
-        int distSB = manhattan(s, b);
-        
-        int distSY = abs(y - s.y);
-        if (distSY > distSB)
-            continue;
-
-        int hSizeAtY = distSB - distSY;
-        int minx = s.x - hSizeAtY;
-        int maxx = s.x + hSizeAtY;
+    auto sensors = readSensors(input);
 
-        intervals.emplace_back(minx, maxx);
-    }
-
-    coalesceIntervals(intervals);
+    vector<int> rowDist;
+    IntervalSet<int> coverage;
+    findCoverage(sensors, y, rowDist, coverage);
 
     // cut holes for beacons
-    for (int bx : beaconsOnRow)
+    for (size_t i = 0; i < sensors.beacons.size(); ++i)
     {
-        bool done;
-        do {
-            done = true;
-            for (auto& i : intervals)
-            {
-                if (i.first == bx)
-                    ++i.first;
-                else if (i.second == bx)
-                    --i.second;
-                else if (i.first < bx && i.second > bx)
-                {
-                    pair<int, int> newInt{ bx + 1,i.second };
-                    i.second = bx - 1;
-                    intervals.push_back(newInt);
-                    done = false;
-                    break;
-                }
-            }
-
-        } while (!done);
+        if (sensors.beacons.ys()[i] == y)
+            coverage.subtract(sensors.beacons.xs()[i]);
     }
 
-    // remove any inside-out intervals
-    intervals.erase(remove_if(begin(intervals), end(intervals), [](auto& i) { return i.first > i.second; }), end(intervals));
-
-    return accumulate(begin(intervals), end(intervals), 0, [](int acc, auto& interval) { return acc + (interval.second - interval.first + 1); });
+    return coverage.coveredLength();
 }
 
 i64 day15_2(const stringlist& input, int maxCoord)
 {
     auto tuningFrequency = [](i64 x, i64 y) -> i64 { return (x * 4000000) + y; };
 
-    auto reports = readReports(input);
-    vector<pair<int, int>> intervals;
+    auto sensors = readSensors(input);
+    vector<int> rowDist;
+    IntervalSet<int> coverage;
+    coverage.reserve(sensors.pos.size());
     for (int y=0; y<=maxCoord; ++y)
     {
-        intervals.clear();
-        intervals.reserve(reports.size());
-
-        for (auto& [s,b] : reports)
-        {
-            int distSB = manhattan(s, b);
-            int distSY = abs(y - s.y);
-            if (distSY > distSB)
-                continue;
-
-            int hSizeAtY = distSB - distSY;
-            int minx = s.x - hSizeAtY;
-            int maxx = s.x + hSizeAtY;
-
-            intervals.emplace_back(minx, maxx);
-        }
-        if (intervals.empty())
-            continue;
-
-        coalesceIntervals(intervals);
-
-        if (intervals.front().first > 0)
-            return tuningFrequency(0, y);
-        if (intervals.back().second < maxCoord)
-            return tuningFrequency(maxCoord, 0);
-        if (intervals.size() > 1)
-            return tuningFrequency(intervals.front().second + 1, y);
+        findCoverage(sensors, y, rowDist, coverage);
+        if (auto x = coverage.firstGap(0, maxCoord))
+            return tuningFrequency(*x, y);
     }
 
     return -1;
@@ -174,8 +110,8 @@ Sensor at x=14, y=3: closest beacon is at x=15, y=3
 Sensor at x=20, y=1: closest beacon is at x=15, y=3)";
 
     test(26, day15(READ(sample), 10));
-    nonono(day15(LOAD(15), 2000000), 4724228);
+    gogogo(day15(LOAD(15), 2000000), 4724228);
 
-    nest(56000011ll, day15_2(READ(sample), 20));
-    nonono(day15_2(LOAD(15), 4000000), 13622251246513ll);
+    test(56000011ll, day15_2(READ(sample), 20));
+    nononoD(day15_2(LOAD(15), 4000000), 13622251246513ll);
 }
\ No newline at end of file
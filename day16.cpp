@@ -1,13 +1,17 @@
 #include "pch.h"
 #include "harness.h"
+#include "bitmask.h"
+#include "branchbound.h"
+#include "graph.h"
 
 
-using ValveIx = u8;
+using RoomIx = u16;     // any room in the cave
+using ValveIx = u8;     // just the rooms worth visiting
 
 struct Valve
 {
     int rate;
-    vector<ValveIx> neighbours;
+    vector<RoomIx> neighbours;
     string name;
     vector<string> tunnelNames;
 };
@@ -23,11 +27,13 @@ struct ValveNode
     string name;
     vector<u8> costToValve;
 };
+// the valve sets are masks with a bit per room worth visiting; Mask is whatever's wide enough
+template<typename Mask>
 struct ValveGraph
 {
     vector<ValveNode> nodes;
     u32 maxFlowRate = 0;
-    u16 allValvesMask = 0;
+    Mask allValvesMask{};
 };
 
 vector<Valve> loadValves(const stringlist& input)
@@ -60,124 +66,100 @@ vector<Valve> loadValves(const stringlist& input)
 
     ranges::sort(valves, {}, &Valve::name);
 
+    unordered_map<string, RoomIx> roomIxs;
+    roomIxs.reserve(valves.size());
+    for (RoomIx i = 0; i < RoomIx(size(valves)); ++i)
+        roomIxs.emplace(valves[i].name, i);
+
     for (auto& v : valves)
     {
         v.neighbours.reserve(size(v.tunnelNames));
         for (auto& neighName : v.tunnelNames)
-        {
-            auto itNeigh = ranges::find(valves, neighName, &Valve::name);
-            v.neighbours.push_back(ValveIx(distance(begin(valves), itNeigh)));
-        }
+            v.neighbours.push_back(roomIxs.at(neighName));
     }
 
     return valves;
 }
 
-ValveIx findValveIx(const string& name, const vector<Valve>& valves)
+bool isRoom(const Valve& v)
 {
-    auto itValve = ranges::find(valves, name, &Valve::name);
-    return ValveIx(distance(begin(valves), itValve));
-};
+    return v.rate > 0 || v.name == "AA";
+}
 
-u8 findMinCost(const string& aName, const string& bName, const vector<Valve>& valves)
+// calls fn.template operator()<Mask>() with the narrowest mask that has room for all the valves
+template<typename Fn>
+auto withValveMask(const vector<Valve>& valves, Fn&& fn)
 {
-    constexpr auto MaxCost = numeric_limits<u8>::max();
-
-    ValveIx aIx = findValveIx(aName, valves);
-    ValveIx bIx = findValveIx(bName, valves);
-
-    vector<u8> best(size(valves), MaxCost);
-    best[aIx] = 0;
+    const size_t numRooms = ranges::count_if(valves, isRoom);
+    if (numRooms <= 16)
+        return fn.template operator()<u16>();
+    if (numRooms <= 32)
+        return fn.template operator()<u32>();
+    if (numRooms <= 64)
+        return fn.template operator()<u64>();
+    if (numRooms <= 128)
+        return fn.template operator()<bitset<128>>();
+
+    throw "too many valves";
+}
 
-    vector<ValveIx> prev(size(valves), numeric_limits<ValveIx>::max());
-    vector<ValveIx> open(size(valves));
-    ranges::iota(open, ValveIx(0));
+template<typename Mask>
+ValveGraph<Mask> optimiseTunnels(const vector<Valve>& valves)
+{
+    ValveGraph<Mask> g;
 
-    while(!empty(open))
+    IndexedGraph<RoomIx> tunnels;
+    vector<RoomIx> rooms;
+    for (RoomIx i = 0; i < RoomIx(size(valves)); ++i)
     {
-        auto itCurrIx = ranges::min_element(open, [&best](ValveIx a, ValveIx b) { return best[a] < best[b]; });
-        ValveIx currIx = *itCurrIx;
-        if (currIx == bIx)
-            return best[currIx];
-
-        erase_unsorted(open, itCurrIx);
+        const Valve& v = valves[i];
+        tunnels.addNode(v.neighbours);
 
-        const Valve& curr = valves[currIx];
-
-        for (ValveIx neighIx : curr.neighbours)
+        if (isRoom(v))
         {
-            if (ranges::find(open, neighIx) == end(open))
-                continue;
-
-            u8 newCost = best[currIx] + 1;
-            if (newCost < best[neighIx])
-            {
-                best[neighIx] = newCost;
-                prev[neighIx] = currIx;
-            }
+            rooms.push_back(i);
+            g.nodes.push_back({ .rate = u16(v.rate), .name = v.name });
         }
     }
 
-    throw "no path";
-}
-
-ValveGraph optimiseTunnels(const vector<Valve>& valves)
-{
-    ValveGraph g;
-    auto findNodeIx = [&g](const string& name) -> ValveIx { return ValveIx(distance(begin(g.nodes), ranges::find(g.nodes, name, &ValveNode::name))); };
-    auto isRoom = [](const Valve& v) { return v.rate > 0 || v.name == "AA"; };
-
-    for (auto& v : valves | views::filter(isRoom))
-        g.nodes.push_back({ .rate = u16(v.rate), .name = v.name });
+    const size_t numRooms = size(rooms);
+    if (numRooms > maskWidth<Mask>)
+        throw "too many valves for the mask type";
 
-    for (auto& v : g.nodes)
-        v.costToValve.resize(g.nodes.size(), 0);
-
-    // find min cost btw each pair of rooms
-    for (auto itA=begin(g.nodes); (itA+1) != end(g.nodes); ++itA)
-    {
-        for (auto itB = itA+1; itB != end(g.nodes); ++itB)
-        {
-            u8 cost = findMinCost(itA->name, itB->name, valves);
-            itA->costToValve[findNodeIx(itB->name)] = cost;
-            itB->costToValve[findNodeIx(itA->name)] = cost;
-        }
-    }
+    // min cost btw each pair of rooms, all in one go
+    vector<u8> costs = tunnels.findHopsBetween<u8>(rooms);
+    for (size_t a = 0; a < numRooms; ++a)
+        g.nodes[a].costToValve.assign(begin(costs) + a * numRooms, begin(costs) + (a + 1) * numRooms);
 
     g.maxFlowRate = accumulate(begin(g.nodes), end(g.nodes), 0u, [](u32 acc, auto& v) { return acc + v.rate; });
-    g.allValvesMask = u16((1 << size(g.nodes)) - 1);
+    g.allValvesMask = lowBits<Mask>(u32(numRooms));
 
     return g;
 }
 
 
+template<typename Mask>
 struct GraphState
 {
-    const ValveGraph& graph;
+    const ValveGraph<Mask>& graph;
 
     u32 totalReleased = 0;
     u16 currentFlowRate = 0;
-    u16 valvesOpen = 1;
+    Mask valvesOpen = maskBit<Mask>(0);
     i8 minute = 1;
     ValveIx location = 0;
+    u8 moves = 0;
 };
 
-ostream& operator<<(ostream& os, const GraphState& s)
+template<typename Mask>
+ostream& operator<<(ostream& os, const GraphState<Mask>& s)
 {
     os << "== Minute " << int(s.minute) << " (" << s.graph.nodes[s.location].name << ") ==\n";
     os << "  Valves open ";
-    if (s.valvesOpen)
-    {
-        for (u32 i=0, mask=1; i<16; ++i, mask <<= 1)
-        {
-            if (s.valvesOpen & mask)
-                os << s.graph.nodes[i].name << " ";
-        }
-    }
+    if (!noBits(s.valvesOpen))
+        forEachBit(s.valvesOpen, [&](u32 i) { os << s.graph.nodes[i].name << " "; });
     else
-    {
         os << "none ";
-    }
 
     os << ", releasing " << s.currentFlowRate << " pressure. " << s.totalReleased << " released before now.\n";
 
@@ -185,7 +167,8 @@ ostream& operator<<(ostream& os, const GraphState& s)
 }
 
 
-bool tick(GraphState& state, int count, u32& mostReleased)
+template<typename Mask>
+bool tick(GraphState<Mask>& state, int count, auto& worker)
 {
     if (count == 0) [[unlikely]]
         throw "hm";
@@ -196,9 +179,10 @@ bool tick(GraphState& state, int count, u32& mostReleased)
     u32 thisFlow = thisFlowTime * state.currentFlowRate;
     int finalFlowTime = max(0, 31 - (state.minute + thisFlowTime));
     int finalFlow = finalFlowTime * state.graph.maxFlowRate;
-    if (state.totalReleased + thisFlow + finalFlow < mostReleased)
+    if (state.totalReleased + thisFlow + finalFlow < worker.best())
     {
         state.minute = 31;
+        worker.prune();
         return false;
     }
 
@@ -207,37 +191,35 @@ bool tick(GraphState& state, int count, u32& mostReleased)
 
     if (state.minute > 30)
     {
-        if (state.totalReleased > mostReleased)
-        {
-            mostReleased = state.totalReleased;
-//            cout << "found new max release of " << mostReleased << endl;
-        }
+        worker.offer(state.totalReleased);
         return false;
     }
     return true;
 }
 
 
-void takeNextAction(const GraphState& state, u32& mostReleased);
+template<typename Mask>
+void takeNextAction(const GraphState<Mask>& state, auto& worker);
 
-inline void tryOpeningValve(const GraphState& state, u32& mostReleased)
+template<typename Mask>
+inline void tryOpeningValve(const GraphState<Mask>& state, auto& worker)
 {
     const ValveNode& room = state.graph.nodes[state.location];
 
-    const u16 roomMask = 1 << state.location;
-    if (room.rate > 0 && !(state.valvesOpen & roomMask))
+    if (room.rate > 0 && !testBit(state.valvesOpen, state.location))
     {
-        GraphState newState = state;
-        if (tick(newState, 1, mostReleased))
+        GraphState<Mask> newState = state;
+        if (tick(newState, 1, worker))
         {
-            newState.valvesOpen |= roomMask;
+            newState.valvesOpen |= maskBit<Mask>(state.location);
             newState.currentFlowRate += room.rate;
-            takeNextAction(newState, mostReleased);
+            takeNextAction(newState, worker);
         }
     }
 }
 
-inline void tryMovingToRoom(const GraphState& state, ValveIx dest, u32& mostReleased)
+template<typename Mask>
+inline void tryMovingToRoom(const GraphState<Mask>& state, ValveIx dest, auto& worker)
 {
     const ValveNode& room = state.graph.nodes[state.location];
     u8 cost = room.costToValve[dest];
@@ -245,146 +227,330 @@ inline void tryMovingToRoom(const GraphState& state, ValveIx dest, u32& mostRele
     if (state.minute + cost > 30)
         return; // can't be done
 
-    GraphState newState = state;
-    if (!tick(newState, cost, mostReleased))
+    GraphState<Mask> newState = state;
+    if (!tick(newState, cost, worker))
         return; // this was a fruitless action
 
     newState.location = dest;
-    takeNextAction(newState, mostReleased);
+    ++newState.moves;
+
+    if (worker.shouldSplit(newState.moves))
+        worker.spawn(newState);
+    else
+        takeNextAction(newState, worker);
 }
 
-void takeNextAction(const GraphState& state, u32& mostReleased)
+template<typename Mask>
+void takeNextAction(const GraphState<Mask>& state, auto& worker)
 {
-    tryOpeningValve(state, mostReleased);
+    worker.visit();
+    tryOpeningValve(state, worker);
 
     if (state.valvesOpen != state.graph.allValvesMask)
     {
-        u16 mask = 1;
-        for (ValveIx i=0; i<ValveIx(size(state.graph.nodes)); ++i, mask <<= 1)
+        for (ValveIx i=0; i<ValveIx(size(state.graph.nodes)); ++i)
         {
-            if (i == state.location || state.valvesOpen & mask)
+            if (i == state.location || testBit(state.valvesOpen, i))
                 continue;
 
-            tryMovingToRoom(state, i, mostReleased);
+            tryMovingToRoom(state, i, worker);
         }
     }
 
     // try running out the clock in here
-    GraphState newState = state;
-    tick(newState, 100, mostReleased);
+    GraphState<Mask> newState = state;
+    tick(newState, 100, worker);
 }
 
 
-ValveIx findBestMove(const GraphState& state)
+template<typename Mask>
+u32 findBestPath(const ValveGraph<Mask>& graph, u32 numWorkers = thread::hardware_concurrency())
 {
-    auto& rooms = state.graph.nodes;
-    const ValveNode& room = rooms[state.location];
+    using ValveSearch = ParallelBranchAndBound<GraphState<Mask>>;
+    GraphState<Mask> state{ graph };
 
-    ValveIx best = numeric_limits<ValveIx>::max();
-    u32 bestRelease = 0;
+    ValveSearch search(numWorkers);
+    u32 mostReleased = search.run(span(&state, 1), [](const GraphState<Mask>& s, auto& worker) { takeNextAction(s, worker); });
+
+    cout << "  " << search.totalStats() << endl << "  nodes per worker:";
+    for (const BranchStats& stats : search.stats())
+        cout << " " << stats.nodes;
+    cout << endl;
+
+    return mostReleased;
+}
 
-    int minutesLeft = (31 - 1) - state.minute;  // -1 because we need to turn the valve on
 
-    u16 mask = 1 << 1;
-    for (ValveIx i = 1; i < ValveIx(size(state.graph.nodes)); ++i, mask <<= 1)
+// remembers the best release still to come from each (location, valves open, minute) state, so a
+// state reached by moves in a different order is a lookup rather than a whole subtree. valve 0 is
+// AA, which starts open, so it isn't part of the key. while every state fits in a few MB they
+// each get a slot in one flat table; beyond that only the states we actually reach get stored,
+// keyed on one u64 while the mask is small enough to share it
+template<typename Mask>
+class ValveMemo
+{
+public:
+    explicit ValveMemo(const ValveGraph<Mask>& graph)
+        : m_numRooms(u32(size(graph.nodes)))
+        , m_maskBits(m_numRooms - 1)
     {
-        if (state.valvesOpen & mask)
-            continue;
+        if constexpr (is_integral_v<Mask>)
+        {
+            // only worth it while the table is small next to the states we'll actually visit
+            if (m_maskBits <= MaxDenseValves)
+            {
+                const u64 denseSlots = u64(MaxMinute + 1) * m_numRooms << m_maskBits;
+                if (denseSlots * sizeof(u32) <= MaxDenseBytes)
+                    m_dense.assign(size_t(denseSlots), Unknown);
+            }
+        }
+    }
+
+    optional<u32> find(const GraphState<Mask>& state)
+    {
+        ++m_lookups;
+        if (!m_dense.empty())
+        {
+            const u32 val = m_dense[denseIx(state)];
+            if (val == Unknown)
+                return nullopt;
+
+            ++m_hits;
+            return val;
+        }
+
+        auto it = m_sparse.find(key(state));
+        if (it == end(m_sparse))
+            return nullopt;
+
+        ++m_hits;
+        return it->second;
+    }
+
+    void store(const GraphState<Mask>& state, u32 future)
+    {
+        if (future >= Unknown)
+            throw "too much pressure to remember";
+
+        if (!m_dense.empty())
+            m_dense[denseIx(state)] = future;
+        else
+            m_sparse.emplace(key(state), future);
+    }
+
+    double hitRate() const      { return m_lookups ? double(m_hits) / m_lookups : 0.0; }
+    u64 lookups() const         { return m_lookups; }
+
+private:
+    static constexpr u32 MaxDenseValves = 16;
+    static constexpr u64 MaxDenseBytes = 4 << 20;
+    static constexpr u32 MaxMinute = 30;
+    static constexpr u32 Unknown = numeric_limits<u32>::max();
+
+    struct WideKey
+    {
+        Mask valvesOpen;
+        u16 where;      // minute and location
+
+        bool operator==(const WideKey&) const = default;
+    };
+    struct WideKeyHash
+    {
+        size_t operator()(const WideKey& k) const { return hash<Mask>()(k.valvesOpen) ^ (k.where * 0x9E3779B97F4A7C15ull); }
+    };
 
-        u8 cost = room.costToValve[i];
+    static constexpr bool PackedKey = is_integral_v<Mask> && maskWidth<Mask> <= 32;
+    using Key = conditional_t<PackedKey, u64, WideKey>;
+    using KeyHash = conditional_t<PackedKey, hash<u64>, WideKeyHash>;
 
-        if (state.minute + cost > 30)
-            throw "ono";
+    size_t denseIx(const GraphState<Mask>& state) const
+    {
+        if constexpr (is_integral_v<Mask>)
+            return (size_t(state.minute) * m_numRooms + state.location) << m_maskBits | size_t(state.valvesOpen >> 1);
+        else
+            return 0;
+    }
+    Key key(const GraphState<Mask>& state) const
+    {
+        const u16 where = u16(state.minute * m_numRooms + state.location);
+        if constexpr (PackedKey)
+            return u64(where) << 32 | u64(state.valvesOpen);
+        else
+            return { state.valvesOpen, where };
+    }
 
-        u32 totalRelease = (minutesLeft - cost) * rooms[i].rate;
+    u32 m_numRooms;
+    u32 m_maskBits;
+    vector<u32> m_dense;
+    unordered_map<Key, u32, KeyHash> m_sparse;
+    u64 m_lookups = 0;
+    u64 m_hits = 0;
+};
 
-        if (totalRelease > bestRelease)
+// the most that can still be released by valves opened from here on: the same open / move /
+// wait it out choices as takeNextAction, but memoised instead of bounded
+template<typename Mask>
+u32 bestFutureRelease(const GraphState<Mask>& state, ValveMemo<Mask>& memo)
+{
+    if (auto known = memo.find(state))
+        return *known;
+
+    const ValveGraph<Mask>& graph = state.graph;
+    const ValveNode& room = graph.nodes[state.location];
+    u32 best = 0;   // waiting it out
+
+    // turning it takes this minute, then it flows until the end of minute 30
+    if (room.rate > 0 && !testBit(state.valvesOpen, state.location) && state.minute < 30)
+    {
+        GraphState<Mask> newState = state;
+        newState.valvesOpen |= maskBit<Mask>(state.location);
+        ++newState.minute;
+        best = max(best, room.rate * u32(30 - state.minute) + bestFutureRelease(newState, memo));
+    }
+
+    if (state.valvesOpen != graph.allValvesMask)
+    {
+        for (ValveIx i = 0; i < ValveIx(size(graph.nodes)); ++i)
         {
-            best = i;
-            bestRelease = totalRelease;
+            if (i == state.location || testBit(state.valvesOpen, i) || state.minute + room.costToValve[i] > 30)
+                continue;
+
+            GraphState<Mask> newState = state;
+            newState.location = i;
+            newState.minute += i8(room.costToValve[i]);
+            best = max(best, bestFutureRelease(newState, memo));
         }
     }
 
+    memo.store(state, best);
     return best;
 }
 
-
-u32 findBestPath(const ValveGraph& graph)
+template<typename Mask>
+u32 findBestPathMemoised(const ValveGraph<Mask>& graph)
 {
-    GraphState state{ graph };
+    ValveMemo<Mask> memo(graph);
+    u32 mostReleased = bestFutureRelease(GraphState<Mask>{ graph }, memo);
+
+    cout << "  memo: " << memo.lookups() << " lookups, " << fixed << setprecision(1) << memo.hitRate() * 100 << "% hits" << defaultfloat << endl;
 
-#if 0
-    u32 mostReleased = 0;
-    takeNextAction(state, mostReleased);
     return mostReleased;
+}
 
-#elif 0
 
-    u32 mostReleased = 0;
-    while (state.valvesOpen != state.graph.allValvesMask)
+// every order of opening valves that fits in the time, calling record(valvesOpen, released) for
+// each: how much opening exactly those valves (and nothing else) releases by the end
+template<typename Mask>
+void walkValveOrders(const ValveGraph<Mask>& graph, ValveIx location, int minutesLeft, const Mask& valvesOpen, u32 released, auto& record)
+{
+    record(valvesOpen, released);
+
+    const ValveNode& room = graph.nodes[location];
+    for (ValveIx i = 0; i < ValveIx(size(graph.nodes)); ++i)
     {
-        cout << state << endl;
+        if (graph.nodes[i].rate == 0 || testBit(valvesOpen, i))
+            continue;
 
-        ValveIx destRoom = findBestMove(state);
+        // walk there, then a minute to turn it
+        const int left = minutesLeft - room.costToValve[i] - 1;
+        if (left <= 0)
+            continue;
 
-        const ValveNode& curr = state.graph.nodes[state.location];
-        const ValveNode& dest = state.graph.nodes[destRoom];
-        u8 cost = curr.costToValve[destRoom];
+        walkValveOrders(graph, i, left, Mask(valvesOpen | maskBit<Mask>(i)), released + left * graph.nodes[i].rate, record);
+    }
+}
+
+template<typename Mask>
+u32 findMostReleased(const ValveGraph<Mask>& graph)
+{
+    u32 mostReleased = 0;
+    auto record = [&mostReleased](const Mask&, u32 released) { mostReleased = max(mostReleased, released); };
+    walkValveOrders(graph, 0, 30, Mask{}, 0, record);
+    return mostReleased;
+}
 
-        if (!tick(state, cost + 1, mostReleased))
-            throw "wow";
+// the best split of the valves between us and the elephant, with 26 minutes each
+template<typename Mask>
+u32 findMostReleasedWithHelp(const ValveGraph<Mask>& graph)
+{
+    constexpr u32 MaxSubsetTableValves = 20;
+    const u32 numRooms = u32(size(graph.nodes));
 
-        state.location = destRoom;
-        state.valvesOpen |= (1 << destRoom);
-        state.currentFlowRate += dest.rate;
-    }
+    if constexpr (is_integral_v<Mask>)
+    {
+        if (numRooms <= MaxSubsetTableValves)
+        {
+            const u32 allValves = u32(graph.allValvesMask);
+            vector<u32> best(size_t(allValves) + 1, 0);
+            auto record = [&best](const Mask& valvesOpen, u32 released) { best[valvesOpen] = max(best[valvesOpen], released); };
+            walkValveOrders(graph, 0, 26, Mask{}, 0, record);
 
-    cout << state << endl;
-    tick(state, 100, mostReleased);
-    cout << state << endl;
+            // best[mask] becomes the best from opening any subset of mask
+            for (u32 bit = 1; bit <= allValves; bit <<= 1)
+            {
+                for (u32 mask = 0; mask <= allValves; ++mask)
+                {
+                    if (mask & bit)
+                        best[mask] = max(best[mask], best[mask ^ bit]);
+                }
+            }
 
-    return mostReleased;
+            // we take some valves, the elephant gets the rest
+            u32 mostReleased = 0;
+            for (u32 mask = 0; mask <= allValves; ++mask)
+                mostReleased = max(mostReleased, best[mask] + best[allValves ^ mask]);
 
-#else
-    auto numActions = size(graph.nodes);  // +1 for open, -1 for move to this room
+            return mostReleased;
+        }
+    }
 
-    vector<u32> mostPerFirstAction(numActions, 0);
-    vector<thread> threads;
-    threads.reserve(numActions);
+    // too many valves for a table over every subset, so pair up just the sets we can actually
+    // open in time, best first, and stop once no pair left could beat what we've got
+    unordered_map<Mask, u32> bestPerMask;
+    auto record = [&bestPerMask](const Mask& valvesOpen, u32 released)
+    {
+        u32& best = bestPerMask[valvesOpen];
+        best = max(best, released);
+    };
+    walkValveOrders(graph, 0, 26, Mask{}, 0, record);
 
-    threads.emplace_back([&state, &mostPerFirstAction]() { tryOpeningValve(state, mostPerFirstAction[0]); });
+    vector<pair<u32, Mask>> byRelease;
+    byRelease.reserve(bestPerMask.size());
+    for (auto& [mask, released] : bestPerMask)
+        byRelease.emplace_back(released, mask);
+    ranges::sort(byRelease, greater{}, &pair<u32, Mask>::first);
 
-    // try moving to all the other closed valves
-    for (ValveIx i = 1; i < ValveIx(size(graph.nodes)); ++i)
+    u32 mostReleased = 0;
+    for (size_t a = 0; a < byRelease.size(); ++a)
     {
-        threads.emplace_back([i, &state, &mostPerFirstAction]() { tryMovingToRoom(state, i, mostPerFirstAction[i]); });
-    }
+        if (byRelease[a].first * 2 <= mostReleased)
+            break;
 
-    for (auto& t : threads)
-        t.join();
+        for (size_t b = a; b < byRelease.size(); ++b)
+        {
+            const u32 released = byRelease[a].first + byRelease[b].first;
+            if (released <= mostReleased)
+                break;
 
-    return ranges::max(mostPerFirstAction);
-#endif
-}
+            if (noBits(Mask(byRelease[a].second & byRelease[b].second)))
+                mostReleased = released;
+        }
+    }
 
+    return mostReleased;
+}
 
 
 u32 day16(const stringlist& input)
 {
     auto valves = loadValves(input);
-    auto graph = optimiseTunnels(valves);
-
-    return findBestPath(graph);
+    return withValveMask(valves, [&]<typename Mask>() { return findMostReleased(optimiseTunnels<Mask>(valves)); });
 }
 
-int day16_2(const stringlist& input)
+u32 day16_2(const stringlist& input)
 {
-    for (auto& line : input)
-    {
-        (void)line;
-    }
-
-    return -1;
+    auto valves = loadValves(input);
+    return withValveMask(valves, [&]<typename Mask>() { return findMostReleasedWithHelp(optimiseTunnels<Mask>(valves)); });
 }
 
 
@@ -402,10 +568,25 @@ Valve HH has flow rate=22; tunnel leads to valve GG
 Valve II has flow rate=0; tunnels lead to valves AA, JJ
 Valve JJ has flow rate=21; tunnel leads to valve II)";
 
-    test(1651u, day16(READ(sample)));
-    nononoD(day16(LOAD(16)));
+    auto sampleValves = loadValves(READ(sample));
+    auto realValves = loadValves(LOAD(16));
 
-    //test(-100, day16_2(READ(sample)));
-    //gogogo(day16_2(LOAD(16)));
-    skip("i'm bamboozled");
+    test(1651u, day16(READ(sample)));
+    test(1651u, findBestPath(optimiseTunnels<u16>(sampleValves), 4));
+    test(1651u, findBestPathMemoised(optimiseTunnels<u16>(sampleValves)));
+    test(1376u, findBestPathMemoised(optimiseTunnels<u16>(realValves)));
+
+    // the parallel search, with more workers than most boxes have cores, against the serial one
+    test(findBestPathMemoised(optimiseTunnels<u16>(realValves)), findBestPath(optimiseTunnels<u16>(realValves), 6));
+
+    // wider masks should give the same answers
+    test(1376u, findMostReleased(optimiseTunnels<u64>(realValves)));
+    test(1376u, findBestPathMemoised(optimiseTunnels<u64>(realValves)));
+    test(1651u, findBestPathMemoised(optimiseTunnels<bitset<128>>(sampleValves)));
+    gogogo(day16(LOAD(16)), 1376u);
+
+    test(1707u, day16_2(READ(sample)));
+    test(1707u, findMostReleasedWithHelp(optimiseTunnels<bitset<128>>(sampleValves)));
+    test(1933u, findMostReleasedWithHelp(optimiseTunnels<u64>(realValves)));
+    gogogo(day16_2(LOAD(16)), 1933u);
 }
\ No newline at end of file
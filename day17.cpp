@@ -1,40 +1,153 @@
 #include "pch.h"
 #include "harness.h"
 
-#include <execution>
+#include <atomic>
+#include <thread>
 
+
+// a rock is four rows of a 7 wide field packed into one word, bottom row in the low byte and
+// bit 6 of each byte on the left wall, so shifting and collision tests do all the rows at once
 struct Rock
 {
-    u8 shape[4];
+    u32 shape;
+    u32 height;
 };
 
 constexpr Rock Rocks[] = {
-    { 0x1e, 0 },                // -
-    { 0x08, 0x1c, 0x08, 0 },    // +
-    { 0x1c, 0x04, 0x04, 0 },    // mirror L
-    { 0x10, 0x10, 0x10, 0x10 }, // |
-    { 0x18, 0x18, 0 },          // o
+    { 0x0000001e, 1 },      // -
+    { 0x00081c08, 3 },      // +
+    { 0x0004041c, 3 },      // mirror L
+    { 0x10101010, 4 },      // |
+    { 0x00001818, 2 },      // o
 };
 
-using Field = vector<u8>;
+constexpr u32 LeftWall = 0x40404040;
+constexpr u32 RightWall = 0x01010101;
 
-int getRockSize(const Rock& rock)
+// the part of the tower that falling rocks can still get to, as a ring of rows (bit 6 is the
+// left wall side). rows are addressed by their height from the floor however long the tower
+// gets; whenever the ring fills up, everything below the deepest row a rock could still reach is
+// thrown away, so the memory stays fixed however many rocks we drop.
+// the first few rows are mirrored past the end of the ring so any four rows can be read as one
+// word without worrying about the wrap
+class Field
 {
-    return int(ranges::count_if(rock.shape, [](u8 row) { return row != 0; }));
-}
+public:
+    static constexpr u8 FullRow = 0x7f;
+
+    Field() : m_rows(MinCapacity + Mirror, 0), m_mask(MinCapacity - 1) { /**/ }
+
+    u64 height() const      { return m_top; }
+    u64 base() const        { return m_base; }     // rows below here have been discarded
+
+    u8 row(u64 y) const     { return m_rows[y & m_mask]; }
+
+    // rows y to y+3, lined up with a Rock
+    u32 window(u64 y) const
+    {
+        u32 rows;
+        memcpy(&rows, &m_rows[y & m_mask], sizeof(rows));
+        return rows;
+    }
+
+    void place(const Rock& rock, u64 y)
+    {
+        const u32 placed = window(y) | rock.shape;
+        for (u32 i = 0; i < rock.height; ++i)
+            setRow(y + i, u8(placed >> (i * 8)));
+        m_top = max(m_top, y + rock.height);
+    }
+
+    // make sure rows up to (but not including) top have somewhere to go
+    void reserveTo(u64 top)
+    {
+        if (top - m_base <= capacity())
+            return;
+
+        discardUnreachable();
+        if ((top - m_base) * 2 > capacity())
+            regrow(bit_ceil((top - m_base) * 2));
+    }
+
+    // back to an empty field, keeping the ring
+    void clear()
+    {
+        ranges::fill(m_rows, u8(0));
+        m_base = 0;
+        m_top = 0;
+    }
+
+private:
+    static constexpr u32 MinCapacity = 1024;
+    static constexpr u32 Mirror = 3;
+
+    u64 capacity() const    { return m_mask + 1; }
+
+    void setRow(u64 y, u8 bits)
+    {
+        const u64 ix = y & m_mask;
+        m_rows[ix] = bits;
+        if (ix < Mirror)
+            m_rows[ix + capacity()] = bits;
+    }
+
+    // flood down from the open sky through empty cells, going down, left or right the way rocks
+    // do. the first row nothing gets into is the floor as far as any rock cares
+    void discardUnreachable()
+    {
+        u8 reach = FullRow;
+        u64 y = m_top;
+        while (y > m_base)
+        {
+            --y;
+            const u8 open = u8(~row(y) & FullRow);
+            u8 spread = reach & open;
+            for (u8 prev = 0; spread != prev; )
+            {
+                prev = spread;
+                spread |= ((spread << 1) | (spread >> 1)) & open;
+            }
+
+            if (!spread)
+                break;
+            reach = spread;
+        }
+
+        for (; m_base < y; ++m_base)
+            setRow(m_base, 0);
+    }
+
+    void regrow(u64 newCapacity)
+    {
+        Field bigger;
+        bigger.m_rows.assign(newCapacity + Mirror, 0);
+        bigger.m_mask = newCapacity - 1;
+        for (u64 y = m_base; y < m_top; ++y)
+            bigger.setRow(y, row(y));
+
+        m_rows.swap(bigger.m_rows);
+        m_mask = bigger.m_mask;
+    }
+
+    vector<u8> m_rows;
+    u64 m_mask;
+    u64 m_base = 0;
+    u64 m_top = 0;
+};
 
 void drawField(const Field& field, u32 window = 20)
 {
     char rowStr[16] = "|!!!!!!!|\n";
-    for (u8 placed : field | views::reverse | views::take(window))
+    for (u64 y = field.height(); y > field.base() && y + window > field.height(); --y)
     {
+        u8 placed = field.row(y - 1);
         u8 mask = 0x40;
         for (u32 i = 1; i < 8; ++i, mask >>= 1)
             rowStr[i] = (placed & mask) ? '#' : ' ';
         cout << rowStr;
     }
 
-    if (size(field) <= window)
+    if (field.base() == 0 && field.height() <= window)
         cout << "+-------+\n";
 
     cout << endl;
@@ -43,213 +156,284 @@ void drawField(const Field& field, u32 window = 20)
 void drawRock(const Rock& rock)
 {
     char rowStr[16] = "|!!!!!!!|\n";
-    for (u8 placed : rock.shape | views::filter([](auto r) { return r != 0; }) | views::reverse)
+    for (u32 i = rock.height; i-- > 0; )
     {
+        u8 placed = u8(rock.shape >> (i * 8));
         u8 mask = 0x40;
-        for (u32 i = 1; i < 8; ++i, mask >>= 1)
-            rowStr[i] = (placed & mask) ? '@' : '.';
+        for (u32 c = 1; c < 8; ++c, mask >>= 1)
+            rowStr[c] = (placed & mask) ? '@' : '.';
         cout << rowStr;
     }
     cout << endl;
 }
 
 
-
-bool isSettled(const Rock& rock, auto itField)
+// the jets as one bit each (set for <), so pushing a rock is a select rather than a compare
+class Jets
 {
-    for (u8 row : rock.shape)
+public:
+    explicit Jets(string_view pattern)
     {
-        if (row & *itField)
-            return true;
-        ++itField;
+        assign(pattern);
     }
-    return false;
-}
 
-void blowRock(Rock& rock, char dir)
-{
-  //  cout << "blowing rock " << dir << dir << dir << "\n";
-
-    u8 mush = accumulate(begin(rock.shape), end(rock.shape), u8(0), [](u8 acc, u8 row) { return u8(acc | row); });
-    if (dir == '<')
+    // start over with a new pattern, reusing the bits
+    void assign(string_view pattern)
     {
-        if (!(mush & 0x40))
+        if (pattern.empty())
+            throw "no jets to push the rocks with";
+
+        m_left.assign((pattern.size() + 63) / 64, 0);
+        m_size = u32(pattern.size());
+        m_next = 0;
+        for (u32 i = 0; i < m_size; ++i)
         {
-            for (auto& row : rock.shape)
-                row <<= 1;
+            if (pattern[i] == '<')
+                m_left[i / 64] |= 1ull << (i % 64);
         }
     }
-    else
+
+    // true for a push left
+    bool operator()()
     {
-        if (!(mush & 0x01))
-        {
-            for (auto& row : rock.shape)
-                row >>= 1;
-        }
+        const bool left = (m_left[m_next / 64] >> (m_next % 64)) & 1;
+        if (++m_next == m_size)
+            m_next = 0;
+        return left;
     }
+
+    u32 nextIx() const  { return m_next; }
+
+private:
+    vector<u64> m_left;
+    u32 m_size = 0;
+    u32 m_next = 0;
+};
+
+// where the rock ends up after a push, if the walls allow it
+inline u32 blowRock(u32 rock, bool left)
+{
+    const u32 moved = left ? rock << 1 : rock >> 1;
+    const u32 wall = left ? LeftWall : RightWall;
+    return (rock & wall) ? rock : moved;
 }
 
-void tryBlowRock(Rock& rock, char dir, auto itField)
+// ...and if nothing in the field is in the way either
+inline u32 tryBlowRock(u32 rock, bool left, u32 window)
 {
-    Rock testRock = rock;
-    blowRock(testRock, dir);
-    if (!isSettled(testRock, itField))
-        rock = testRock;
+    const u32 moved = blowRock(rock, left);
+    return (moved & window) ? rock : moved;
 }
 
-bool placeRock(const Rock& rock, auto itField)
+// where every rock has got to, plus where we are in the rock and jet sequences
+class Tower
 {
-    bool tetris = false;
-    for (u8 row : rock.shape)
-    {
-        if (row == 0)
-            break;
+public:
+    static constexpr u32 Width = 7;
+    static constexpr u8 MaxSurfaceDepth = 0xff;
 
-        *itField |= row;
-        if (*itField == 0x7f)
-            tetris = true;
+    explicit Tower(string_view jetPattern) : m_jet(jetPattern) { /**/ }
 
-        ++itField;
+    // an empty tower with different jets, without reallocating anything
+    void reset(string_view jetPattern)
+    {
+        m_field.clear();
+        m_jet.assign(jetPattern);
+        m_nextRockIx = 0;
     }
-    return tetris;
-}
 
-inline void trimField(Field& field)
-{
-    while (!field.empty() && field.back() == 0)
-        field.pop_back();
-}
+    void dropRock()
+    {
+        Rock rock = Rocks[m_nextRockIx];
+        ++m_nextRockIx;
+        if (m_nextRockIx >= size(Rocks))
+            m_nextRockIx = 0;
 
-u64 wipeTetris(Field& field)
-{
-    u64 numDeleted = 0;
+        // preroll 3 jets to reach the top; nothing's up there but the walls
+        for (int j = 0; j < 3; ++j)
+            rock.shape = blowRock(rock.shape, m_jet());
 
-    auto itTetris = find(rbegin(field), rend(field), 0x7f);
-    if (itTetris != rend(field))
-    {
-        //       cout << "==== TETRIS ====\n";
-        //       drawField(field, 1000);
-        numDeleted = distance(begin(field), itTetris.base() - 1);
-        field.erase(begin(field), itTetris.base() - 1);
+        u64 y = m_field.height();
+        m_field.reserveTo(y + 4);
+        u32 window = m_field.window(y);
+        for (;;)
+        {
+            rock.shape = tryBlowRock(rock.shape, m_jet(), window);
+            if (y == 0)
+                break;
 
-        //       cout << "\n xxxxxxxxxxxxx \n";
-        //       drawField(field, 1000);
-    }
-    return numDeleted;
-}
+            const u32 below = m_field.window(y - 1);
+            if (rock.shape & below)
+                break;
 
-struct Jets
-{
-    const string& pattern;
-    string::const_iterator itNext;
+            --y;
+            window = below;
+        }
 
-    Jets(const string& input) : pattern(input), itNext(begin(pattern)) { /**/ }
+        m_field.place(rock, y);
+    }
 
-    char operator()()
+    u64 height() const      { return m_field.height(); }
+    u32 rockIx() const      { return m_nextRockIx; }
+    u32 jetIx() const       { return m_jet.nextIx(); }
+
+    // how far below the top each column's highest block is; between that and where we are in
+    // the rocks and jets, the tower will grow the same way whenever this comes round again
+    array<u8, Width> surface() const
     {
-        char jet = *itNext;
-        ++itNext;
-        if (itNext == end(pattern))
-            itNext = begin(pattern);
-        return jet;
+        array<u8, Width> depths;
+        for (u32 col = 0; col < Width; ++col)
+        {
+            const u8 colMask = u8(0x40 >> col);
+            u32 depth = 0;
+            for (u64 y = m_field.height(); y > m_field.base() && depth < MaxSurfaceDepth && !(m_field.row(y - 1) & colMask); --y)
+                ++depth;
+            depths[col] = u8(min(depth, u32(MaxSurfaceDepth)));
+        }
+        return depths;
     }
+
+private:
+    Field m_field;
+    Jets m_jet;
+    u32 m_nextRockIx = 0;
 };
 
+
 u64 day17(const string& jetPattern, u64 iterations)
 {
-    Jets jet(jetPattern);
-
-    Field field;
-    //field.reserve(64 * 1024);
-    u64 tetrisedRows = 0;
+    Tower tower(jetPattern);
     u64 nextMsg = 100'000'000ull;
 
-    u32 nextRockIx = 0;
     for (u64 i = 0; i < iterations; ++i)
     {
-        Rock rock = Rocks[nextRockIx];
-        ++nextRockIx;
-        if (nextRockIx >= size(Rocks))
-            nextRockIx = 0;
+        tower.dropRock();
 
-        // preroll 3 jets to reach the top
-        for (int j = 0; j < 3; ++j)
-            blowRock(rock, jet());
-        
-        constexpr int Spacing = 4;
-        int offset = -Spacing;
-        field.resize(size(field) + Spacing);
-        auto itField = end(field) + offset;
-        for (;;)
-        {
-            tryBlowRock(rock, jet(), itField);
-            if (itField == begin(field) || isSettled(rock, itField - 1))
-                break;
-
-            --offset;
-            --itField;
-        }
-
-        if (placeRock(rock, itField))
-            tetrisedRows += wipeTetris(field);
-
-        trimField(field);
-
-        if (field.size() + tetrisedRows > nextMsg)
+        if (tower.height() > nextMsg)
         {
             cout << "reached " << ((100.0 * double(nextMsg)) / double(iterations)) << "%..." << endl;
             nextMsg += 100'000'000ull;
         }
     }
 
-    return field.size() + tetrisedRows;
+    return tower.height();
 }
 
-u64 day17_2(const string& input)
+
+struct TowerFingerprint
+{
+    u32 rockIx;
+    u32 jetIx;
+    array<u8, Tower::Width> surface;
+
+    bool operator==(const TowerFingerprint&) const = default;
+};
+
+struct TowerFingerprintHash
 {
-    constexpr u64 TargetCount = 1000000000000ull;
-    //return day17(input, Target);
-
-    u64 inputLoopPoint = size(input) * size(Rocks);
-
-    vector<u64> heightsPerLoop(50);
-    vector<u32> indices(heightsPerLoop.size() - 1);
-    ranges::iota(indices, 1);
-    for_each(execution::par_unseq, begin(indices), end(indices), [&heightsPerLoop,&input,inputLoopPoint](u32 i)
-        { heightsPerLoop[i] = day17(input, inputLoopPoint * i); });
-
-    u64 loopCount = 0;
-    u64 loopSize = 0;
-    u64 stableCount = 0;
-    u64 stableSize = 0;
-    for (u64 reps = 1; reps + 1 < size(heightsPerLoop) / 3; ++reps)
+    size_t operator()(const TowerFingerprint& fp) const
     {
-        auto lo = heightsPerLoop[reps + 1];
-        auto mid = heightsPerLoop[reps * 2 + 1];
-        auto hi = heightsPerLoop[reps * 3 + 1];
+        u64 surface = 0;
+        for (u8 depth : fp.surface)
+            surface = (surface << 8) | depth;
+        return hash<u64>()(surface ^ (u64(fp.rockIx) << 56) ^ (u64(fp.jetIx) * 0x9E3779B97F4A7C15ull));
+    }
+};
+
+// drops rocks until the tower starts repeating itself, then works the height out from the cycle
+u64 towerHeightAfter(const string& jetPattern, u64 numRocks)
+{
+    Tower tower(jetPattern);
+    vector<u64> heights{ 0 };     // after each number of rocks
+    unordered_map<TowerFingerprint, u64, TowerFingerprintHash> seenAt;
 
-        if (hi - mid == mid - lo)
+    for (u64 rocks = 0; rocks < numRocks; ++rocks)
+    {
+        auto [itSeen, isNew] = seenAt.try_emplace({ tower.rockIx(), tower.jetIx(), tower.surface() }, rocks);
+        if (!isNew)
         {
-            loopCount = inputLoopPoint * reps;
-            loopSize = hi - mid;
+            const u64 cycleStart = itSeen->second;
+            const u64 cycleRocks = rocks - cycleStart;
+            const u64 cycleHeight = heights[rocks] - heights[cycleStart];
 
-            stableCount = inputLoopPoint * (reps + 1);
-            stableSize = heightsPerLoop[reps + 1];
-            break;
+            const u64 cycles = (numRocks - cycleStart) / cycleRocks;
+            const u64 leftOver = (numRocks - cycleStart) % cycleRocks;
+            return heights[cycleStart + leftOver] + cycles * cycleHeight;
         }
+
+        tower.dropRock();
+        heights.push_back(tower.height());
     }
-    if (loopCount == 0)
-        throw "didn't find a loop";
 
-    const u64 headCount = stableCount;
+    return heights.back();
+}
 
-    const u64 bulkRepeats = ((TargetCount - stableCount) / loopCount);
-    const u64 bulkSize = bulkRepeats * loopSize;
+// lots of towers at once, for trying out lots of jet patterns. workers pull jobs off a shared
+// counter and each keeps one Tower going, so its field and jet bits get reused job after job
+struct TowerJob
+{
+    string_view jets;
+    u64 rocks;
+};
 
-    const u64 tailCount = TargetCount - (loopCount * bulkRepeats);
-    const u64 headTailSize = day17(input, tailCount + headCount);
+struct TowerBatch
+{
+    vector<u64> heights;    // one per job
+    double rocksPerSecond = 0;
+};
 
-    return headTailSize + bulkSize - stableSize;
+TowerBatch simulateTowers(span<const TowerJob> jobs, u32 numWorkers = thread::hardware_concurrency())
+{
+    // a throw from a worker thread would just terminate, so check everything up front
+    for (const TowerJob& job : jobs)
+    {
+        if (job.jets.empty())
+            throw "no jets to push the rocks with";
+    }
+
+    TowerBatch batch;
+    batch.heights.resize(jobs.size());
+
+    auto startTime = chrono::high_resolution_clock::now();
+
+    atomic<size_t> nextJob{ 0 };
+    auto work = [&]()
+    {
+        optional<Tower> tower;
+        for (size_t job = nextJob++; job < jobs.size(); job = nextJob++)
+        {
+            if (tower)
+                tower->reset(jobs[job].jets);
+            else
+                tower.emplace(jobs[job].jets);
+
+            for (u64 i = 0; i < jobs[job].rocks; ++i)
+                tower->dropRock();
+
+            batch.heights[job] = tower->height();
+        }
+    };
+
+    vector<thread> threads;
+    numWorkers = max(numWorkers, 1u);
+    threads.reserve(numWorkers - 1);
+    for (u32 i = 1; i < numWorkers; ++i)
+        threads.emplace_back(work);
+    work();
+    for (auto& t : threads)
+        t.join();
+
+    const chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - startTime;
+    const u64 totalRocks = accumulate(begin(jobs), end(jobs), 0ull, [](u64 acc, const TowerJob& job) { return acc + job.rocks; });
+    batch.rocksPerSecond = totalRocks / max(elapsed.count(), 1e-9);
+
+    return batch;
+}
+
+
+u64 day17_2(const string& input)
+{
+    return towerHeightAfter(input, 1000000000000ull);
 }
 
 
@@ -258,10 +442,23 @@ void run_day17()
     string sample = ">>><<><>><<<>><>>><<<>>><<<><<<>><>><<>>";
         
     test(3068u, day17(sample, 2022));
+    test(3068u, towerHeightAfter(sample, 2022));
     gogogo(day17(LOADSTR(17), 2022), 3067ull);
 
-    //test(1514285714288ull, day17_2(sample));
-    // 1514364285023 is too low
-    //gogogo(day17_2(LOADSTR(17)));
-    skip("come back to this...");
-}
\ No newline at end of file
+    // every rotation of the real jets, all at once
+    string jets = LOADSTR(17);
+    vector<string> patterns;
+    vector<TowerJob> jobs;
+    for (size_t i = 0; i < jets.size(); i += 97)
+        patterns.push_back(jets.substr(i) + jets.substr(0, i));
+    for (const string& pattern : patterns)
+        jobs.push_back({ pattern, 2022 });
+
+    TowerBatch batch = simulateTowers(jobs);
+    cout << "  " << jobs.size() << " towers at " << u64(batch.rocksPerSecond) << " rocks/sec" << endl;
+    test(3067ull, batch.heights.front());
+    test(day17(patterns.back(), 2022), batch.heights.back());
+
+    test(1514285714288ull, day17_2(sample));
+    gogogo(day17_2(LOADSTR(17)));
+}
@@ -1,26 +1,33 @@
 #include "pch.h"
 #include "harness.h"
 #include "pt3.h"
+#include "pointssoa.h"
+#include "vector3d.h"
 
 using Pt = Pt3<i16>;
 
-constexpr Pt Directions[] = { {1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,1}, {0,0,-1} };
+PointsSoA<Pt> loadDroplets(const stringlist& input)
+{
+    PointsSoA<Pt> droplets;
+    droplets.reserve(input.size());
+    for (auto& line : input)
+        droplets.push_back(Pt(line));
+    return droplets;
+}
+
 
 int day18(const stringlist& input)
 {
-    set<Pt> droplets;
-    for (auto& line : input)
-        droplets.emplace(line);
+    auto droplets = loadDroplets(input);
+    auto [lo, hi] = droplets.bounds();
 
-    int nsides = 6 * int(size(droplets));
-    for (const auto& d : droplets)
-    {
-        for (const Pt& dir : Directions)
-        {
-            if (droplets.contains(d + dir))
-                --nsides;
-        }
-    }
+    bitvector3d<i16> lava(lo, hi);
+    for (size_t i = 0; i < droplets.size(); ++i)
+        lava.set(droplets[i]);
+
+    int nsides = 0;
+    for (size_t i = 0; i < droplets.size(); ++i)
+        nsides += 6 - int(lava.countNeighbours(lava.indexOf(droplets[i])));
 
     return nsides;
 }
@@ -29,55 +36,42 @@ enum class Cell : u8 { Air, Lava, Water };
 
 int day18_2(const stringlist& input)
 {
-    vector<Pt> droplets;
-    ranges::transform(input, back_inserter(droplets), [](auto& line) { return Pt(line); });
-    auto [loX, hiX] = ranges::minmax(droplets | views::transform([](auto& p) { return p.x; }));
-    auto [loY, hiY] = ranges::minmax(droplets | views::transform([](auto& p) { return p.y; }));
-    auto [loZ, hiZ] = ranges::minmax(droplets | views::transform([](auto& p) { return p.z; }));
-    Pt lo(loX, loY, loZ);
-    Pt hi(hiX, hiY, hiZ);
-    Pt size = (hi - lo) + Pt{ 3,3,3 };
-    Pt offset = lo - Pt{ 1,1,1 };
-
-    vector<Cell> cells(size.x * size.y * size.z, Cell::Air);
-    auto getCell = [&cells, &size, &offset](const Pt& cell)
-    {
-        Pt p = cell - offset;
-        if (p.x < 0 || p.y < 0 || p.z < 0 || p.x >= size.x || p.y >= size.y || p.z >= size.z)
-            return Cell::Water;
-        return cells[p.x + (p.y * size.x) + (p.z * size.x * size.y)];
-    };
-    auto setCell = [&cells, &size, &offset](const Pt& cell, Cell c)
-    {
-        Pt p = cell - offset;
-        cells[p.x + (p.y * size.x) + (p.z * size.x * size.y)] = c;
-    };
-
-    for (const auto& drop : droplets)
-        setCell(drop, Cell::Lava);
-
-    vector<Pt> open;
-    open.push_back(lo - Pt(1,1,1));
+    auto droplets = loadDroplets(input);
+    auto [lo, hi] = droplets.bounds();
+
+    // leave a layer of air all round the droplet for the water to flow through; the grid's own
+    // border outside that is already water, so the fill never needs a bounds check
+    vector3d<Cell, i16> cells(lo - Pt(1,1,1), hi + Pt(1,1,1), Cell::Air, Cell::Water);
+    for (size_t i = 0; i < droplets.size(); ++i)
+        cells[droplets[i]] = Cell::Lava;
+
+    using Index = decltype(cells)::index;
+    vector<Index> open;
+    open.push_back(cells.indexOf(cells.lo()));
+    cells[open.back()] = Cell::Water;
     while (!open.empty())
     {
-        Pt curr = open.back();
+        Index curr = open.back();
         open.pop_back();
-        setCell(curr, Cell::Water);
 
-        for (const Pt& dir : Directions)
+        for (i32 stride : cells.neighbourStrides())
         {
-            Pt p = curr + dir;
-            if (getCell(p) == Cell::Air)
-                open.push_back(p);
+            Index n = Index(i32(curr) + stride);
+            if (cells[n] == Cell::Air)
+            {
+                cells[n] = Cell::Water;
+                open.push_back(n);
+            }
         }
     }
 
     int nsides = 0;
-    for (const auto& d : droplets)
+    for (size_t i = 0; i < droplets.size(); ++i)
     {
-        for (const Pt& dir : Directions)
+        const Index ix = cells.indexOf(droplets[i]);
+        for (i32 stride : cells.neighbourStrides())
         {
-            if (getCell(d + dir) == Cell::Water)
+            if (cells[Index(i32(ix) + stride)] == Cell::Water)
                 ++nsides;
         }
     }
@@ -85,7 +79,6 @@ int day18_2(const stringlist& input)
     return nsides;
 }
 
-
 void run_day18()
 {
     string sample =
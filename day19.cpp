@@ -1,28 +1,13 @@
 #include "pch.h"
 #include "harness.h"
 
-#include <execution>
-
-#include <xmmintrin.h>
-#include <emmintrin.h>
-#include <smmintrin.h>
 
 enum Resource { Ore, Clay, Obsidian, Geode, ResourceTypeCount };
 
-using vecI = __m128i;
-
-const vecI VecOre       = _mm_set_epi32(1, 0, 0, 0);
-const vecI VecClay      = _mm_set_epi32(0, 1, 0, 0);
-const vecI VecObsidian  = _mm_set_epi32(0, 0, 1, 0);
-const vecI VecGeode     = _mm_set_epi32(0, 0, 0, 1);
-
-const vecI VecRes[ResourceTypeCount] = { VecOre, VecClay, VecObsidian, VecGeode };
-
-#define VecZero _mm_setzero_si128()
-
 struct Blueprint
 {
-    vecI bots[ResourceTypeCount];
+    int costs[ResourceTypeCount][ResourceTypeCount] = {};     // [bot][resource]
+    int maxSpend[ResourceTypeCount] = {};   // the most of each we could ever use in a minute
     int id = 0;
 
     explicit Blueprint(const string& line)
@@ -40,242 +25,145 @@ struct Blueprint
             "Each obsidian robot costs " >> obsidianBotOre >> " ore and " >> obsidianBotClay >> " clay. "
             "Each geode robot costs " >> geodeBotOre >> " ore and " >> geodeBotObsidian >> " obsidian.";
 
-        bots[Ore] = _mm_set_epi32(oreBotOre, 0, 0, 0);
-        bots[Clay] = _mm_set_epi32(clayBotOre, 0, 0, 0);
-        bots[Obsidian] = _mm_set_epi32(obsidianBotOre, obsidianBotClay, 0, 0);
-        bots[Geode] = _mm_set_epi32(geodeBotOre, 0, geodeBotObsidian, 0);
-    }
-};
-
-struct Inventory
-{
-    vecI resources;   // in order as Resource enum
-    vecI bots;
+        costs[Ore][Ore] = oreBotOre;
+        costs[Clay][Ore] = clayBotOre;
+        costs[Obsidian][Ore] = obsidianBotOre;
+        costs[Obsidian][Clay] = obsidianBotClay;
+        costs[Geode][Ore] = geodeBotOre;
+        costs[Geode][Obsidian] = geodeBotObsidian;
 
-    Inventory() : resources(VecZero), bots(VecOre) { /**/ }
-    
-    int getNumGeodes() const
-    {
-        return _mm_extract_epi32(resources, 0/*Geode*/);    // NB. _mm_set_epi32 loads in reverse order
+        for (int bot = Ore; bot <= Geode; ++bot)
+        {
+            for (int res = Ore; res <= Obsidian; ++res)
+                maxSpend[res] = max(maxSpend[res], costs[bot][res]);
+        }
     }
 };
 
 
-// plans are compressed strings of "the next bot to build"
-struct BotPlan
+// depth first over "which bot next", waiting however long it takes to afford it. geodes are
+// counted up front for the whole of the time left as soon as a geode bot is built, so a
+// state's geodes is already what it ends with if nothing else gets built
+class GeodeSearch
 {
-    enum { MaxPlanLen = 31 };
-    u64 plan = 0;
+public:
+    explicit GeodeSearch(const Blueprint& bp) : m_bp(bp) { /**/ }
 
-    void setStep(int step, Resource res)
-    {
-        const u8 shift = u8(step * 2);
-        const u64 mask = u64(3) << shift;
-        plan = (plan & ~mask) | (u64(res) << shift);
-    }
-    Resource getStep(u32 step) const
+    int mostGeodes(int minutes)
     {
-        const u8 shift = u8(step * 2);
-        return Resource((plan >> shift) & 3);
+        m_best = 0;
+        State start;
+        start.bots[Ore] = 1;
+        search(start, minutes);
+        return m_best;
     }
 
-    BotPlan() = default;
-    explicit BotPlan(const char* str)
+private:
+    struct State
     {
-        u32 step = 0;
-        for (;*str; ++str)
-            setStep(step++, Resource(*str - 'a'));
-    }
-
-    bool operator==(const BotPlan& other) const { return plan == other.plan; }
-};
-using BotPlans = vector<BotPlan>;
-
-ostream& operator<<(ostream& os, const BotPlan& plan)
-{
-    Resource maxResource = Ore;
-    for (u32 step = 0; step <= BotPlan::MaxPlanLen; ++step)
-    {
-        Resource r = plan.getStep(step);
-        if (r == Ore && maxResource == Geode)
-            break;
-
-        os << char('a' + r);
-        maxResource = max(r, maxResource);
-    }
-    return os;
-}
-
-template<int MaxMinutes = 25>
-int runPlan(const Blueprint& bp, const BotPlan& plan)
-{
-    Inventory inv;
-    u64 planLeft = plan.plan;
-    Resource bot = Resource(planLeft & 3);
-    planLeft >>= 2;
+        int res[Geode] = {};
+        int bots[Geode] = {};
+        int geodes = 0;
+    };
 
-    u32 step = 0;
-    for (int minute = 1; minute < MaxMinutes; ++minute)
+    // as if a new obsidian bot turned up every minute for free, and a geode bot got built
+    // whenever there was the obsidian for it
+    int optimisticGeodes(const State& s, int minsLeft) const
     {
-        vecI newBots = VecZero;
-
-        vecI unsatisfied = _mm_cmplt_epi32(inv.resources, bp.bots[bot]);
-        if (_mm_testz_si128(unsatisfied, unsatisfied))
+        const int cost = m_bp.costs[Geode][Obsidian];
+        int obsidian = s.res[Obsidian];
+        int obsidianBots = s.bots[Obsidian];
+        int geodes = s.geodes;
+        for (int m = minsLeft; m > 0; --m)
         {
-            inv.resources = _mm_sub_epi32(inv.resources, bp.bots[bot]);
-            newBots = VecRes[bot];
-
-            if (!planLeft) [[unlikely]]
+            if (obsidian >= cost)
             {
-                int minsRemaining = MaxMinutes - minute;
-                inv.resources = _mm_add_epi32(inv.resources, inv.bots);
-                inv.bots = _mm_add_epi32(inv.bots, newBots);
-
-                if (minsRemaining > 1)
-                {
-                    vecI vecMinsRemaining = _mm_set1_epi32(minsRemaining - 1);
-                    vecI remainingResources = _mm_mul_epi32(inv.bots, vecMinsRemaining);
-                    inv.resources = _mm_add_epi32(inv.resources, remainingResources);
-                }
-                break;
+                obsidian -= cost;
+                geodes += m - 1;
             }
-
-            ++step;
-            bot = Resource(planLeft & 3);
-            planLeft >>= 2;
+            obsidian += obsidianBots++;
         }
-
-        inv.resources = _mm_add_epi32(inv.resources, inv.bots);
-        inv.bots = _mm_add_epi32(inv.bots, newBots);
+        return geodes;
     }
 
-    return inv.getNumGeodes();
-}
-
-
-// last is always Geode
-// no Obsidian before Clay
-// no Geode before Obsidian
-void generateRestOfPlan(BotPlan& curr, int i, int len, Resource maxBotBuilt, BotPlans& plans)
-{
-    if (i >= len - 1)
-    {
-        curr.setStep(len - 1, Geode);
-        plans.push_back(curr);
-    }
-    else if (i >= len-2 && (maxBotBuilt < Obsidian))
+    void search(const State& s, int minsLeft)
     {
-        curr.setStep(i, Obsidian);
-        generateRestOfPlan(curr, i + 1, len, Obsidian, plans);
-    }
-    else if (i >= len-3 && (maxBotBuilt < Clay))
-    {
-        curr.setStep(i, Clay);
-        generateRestOfPlan(curr, i + 1, len, Clay, plans);
-    }
-    else
-    {
-        if (i < len/2 && (maxBotBuilt < Obsidian))  // questionable
-        {
-            curr.setStep(i, Ore);
-            generateRestOfPlan(curr, i + 1, len, maxBotBuilt, plans);
-        }
-
-        if (maxBotBuilt < Geode) // questionable
-        {
-            curr.setStep(i, Clay);
-            generateRestOfPlan(curr, i + 1, len, max(Clay, maxBotBuilt), plans);
-        }
-            
-        if (maxBotBuilt >= Clay)
-        {
-            curr.setStep(i, Obsidian);
-            generateRestOfPlan(curr, i + 1, len, max(Obsidian, maxBotBuilt), plans);
-        }
+        m_best = max(m_best, s.geodes);
+        if (optimisticGeodes(s, minsLeft) <= m_best)
+            return;
 
-        if (maxBotBuilt >= Obsidian)
+        // geode bots first, to find a good answer early and make the bound bite
+        for (int bot = Geode; bot >= Ore; --bot)
         {
-            curr.setStep(i, Geode);
-            generateRestOfPlan(curr, i + 1, len, Geode, plans);
-        }
-    }
-}
+            // never more bots than can be spent in a minute, nor when there's already enough
+            // stocked to spend the max every minute till the end
+            if (bot != Geode)
+            {
+                if (s.bots[bot] >= m_bp.maxSpend[bot])
+                    continue;
+                if (s.res[bot] + s.bots[bot] * minsLeft >= m_bp.maxSpend[bot] * minsLeft)
+                    continue;
+            }
 
-template<int MaxLen>
-vector<BotPlan> generateAllPlans()
-{
-    static_assert(MaxLen < BotPlan::MaxPlanLen);
-    TIME_SCOPE(generateAllPlans);
+            // how long to save up for it, if it can be saved up for at all
+            int wait = 0;
+            for (int res = Ore; res <= Obsidian; ++res)
+            {
+                const int need = m_bp.costs[bot][res] - s.res[res];
+                if (need <= 0)
+                    continue;
+                if (s.bots[res] == 0)
+                {
+                    wait = minsLeft;
+                    break;
+                }
+                wait = max(wait, (need + s.bots[res] - 1) / s.bots[res]);
+            }
 
-    BotPlan curr;
-    vector<BotPlan> plans;    
-    plans.reserve(2'000'000'000);
-    for (int len = 5; len <= MaxLen; ++len)
-    {
-        for (Resource res=Ore; res <= Clay; res = Resource(res + 1))
-        {
-            curr.setStep(0, res);
-            generateRestOfPlan(curr, 1, len, res, plans);
+            // minutes left once it's built; anything other than a geode bot needs a few of them to
+            // turn into a geode: ore or obsidian to pay for a geode bot, then that bot to dig one;
+            // clay goes through an obsidian bot first as well
+            const int after = minsLeft - wait - 1;
+            const int MinAfter[] = { 3, 5, 3, 1 };
+            if (after < MinAfter[bot])
+                continue;
+
+            State next = s;
+            for (int res = Ore; res <= Obsidian; ++res)
+                next.res[res] += s.bots[res] * (wait + 1) - m_bp.costs[bot][res];
+            if (bot == Geode)
+                next.geodes += after;
+            else
+                ++next.bots[bot];
+
+            search(next, after);
         }
     }
 
-    return plans;
-}
-
-template<int MaxMinutes = 25>
-int findBestPlan(const Blueprint& bp, const BotPlans& plans)
-{
-    using GeodesPlanPair = pair<int, const BotPlan*>;
-    auto countGeodes = [&bp](const BotPlan& plan) -> GeodesPlanPair
-    {
-        return { runPlan<MaxMinutes>(bp, plan), &plan };
-    };
-    auto reduceMaxGeodes = [](const GeodesPlanPair& acc, const GeodesPlanPair& val)
-    {
-        if (acc.first >= val.first)
-            return acc;
-        return val;
-    };
-
-    auto [maxGeodes,bestPlan] = transform_reduce(
-        execution::par_unseq,
-        begin(plans), end(plans),
-        GeodesPlanPair{0, nullptr},
-        reduceMaxGeodes,
-        countGeodes);
-
-    if (maxGeodes > 0)
-        cout << "  BP " << bp.id << ": best result " << maxGeodes << " with plan '" << *bestPlan << "'\n";
-    else
-        cout << "  BP " << bp.id << ": no viable plan !!!\n";
-
-    return maxGeodes;
-}
+    const Blueprint& m_bp;
+    int m_best = 0;
+};
 
 
-int day19(const stringlist& input, const BotPlans& plans)
+int day19(const stringlist& input)
 {
-    TIME_SCOPE(day19_exec);
-
     int totalQuality = 0;
     for (auto& line : input)
     {
         Blueprint bp(line);
-        totalQuality += (bp.id * findBestPlan(bp, plans));
+        totalQuality += (bp.id * GeodeSearch(bp).mostGeodes(24));
     }
 
     return totalQuality;
 }
 
-int day19_2(const stringlist& input, const BotPlans& plans)
+int day19_2(const stringlist& input)
 {
-    TIME_SCOPE(day19_2_exec);
-
     int res = 1;
     for (auto& line : input | views::take(3))
     {
         Blueprint bp(line);
-        res *= findBestPlan<33>(bp, plans);
+        res *= GeodeSearch(bp).mostGeodes(32);
     }
 
     return res;
@@ -288,26 +176,17 @@ void run_day19()
 R"(Blueprint 1: Each ore robot costs 4 ore. Each clay robot costs 2 ore. Each obsidian robot costs 3 ore and 14 clay. Each geode robot costs 2 ore and 7 obsidian.
 Blueprint 2: Each ore robot costs 2 ore. Each clay robot costs 3 ore. Each obsidian robot costs 3 ore and 8 clay. Each geode robot costs 3 ore and 12 obsidian.)";
 
-    if constexpr (false)
-    {
-        {
-            auto plans = generateAllPlans<18>();
-            test(14, findBestPlan(Blueprint("Blueprint 24: Each ore robot costs 2 ore. Each clay robot costs 2 ore. Each obsidian robot costs 2 ore and 10 clay. Each geode robot costs 2 ore and 11 obsidian."), plans));
-            test(9, findBestPlan(Blueprint("Blueprint 1: Each ore robot costs 4 ore. Each clay robot costs 2 ore. Each obsidian robot costs 3 ore and 14 clay. Each geode robot costs 2 ore and 7 obsidian."), plans));
-            test(12, findBestPlan(Blueprint("Blueprint 2: Each ore robot costs 2 ore. Each clay robot costs 3 ore. Each obsidian robot costs 3 ore and 8 clay. Each geode robot costs 3 ore and 12 obsidian."), plans));
-            test(33, day19(READ(sample), plans));
-            gogogo(day19(LOAD(19), plans), 1624);
-        }
-        {
-            auto plans = generateAllPlans<25>();
-            test(56, findBestPlan<33>(Blueprint("Blueprint 1: Each ore robot costs 4 ore. Each clay robot costs 2 ore. Each obsidian robot costs 3 ore and 14 clay. Each geode robot costs 2 ore and 7 obsidian."), plans));
-            test(62, findBestPlan<33>(Blueprint("Blueprint 2: Each ore robot costs 2 ore. Each clay robot costs 3 ore. Each obsidian robot costs 3 ore and 8 clay. Each geode robot costs 3 ore and 12 obsidian."), plans));
-            gogogo(day19_2(LOAD(19), plans));
-        }
-    }
-    else
-    {
-        skip("too slow!");
-        skip("too slow!");
-    }
-}
\ No newline at end of file
+    Blueprint bp1("Blueprint 1: Each ore robot costs 4 ore. Each clay robot costs 2 ore. Each obsidian robot costs 3 ore and 14 clay. Each geode robot costs 2 ore and 7 obsidian.");
+    Blueprint bp2("Blueprint 2: Each ore robot costs 2 ore. Each clay robot costs 3 ore. Each obsidian robot costs 3 ore and 8 clay. Each geode robot costs 3 ore and 12 obsidian.");
+    Blueprint bp24("Blueprint 24: Each ore robot costs 2 ore. Each clay robot costs 2 ore. Each obsidian robot costs 2 ore and 10 clay. Each geode robot costs 2 ore and 11 obsidian.");
+
+    test(14, GeodeSearch(bp24).mostGeodes(24));
+    test(9, GeodeSearch(bp1).mostGeodes(24));
+    test(12, GeodeSearch(bp2).mostGeodes(24));
+    test(33, day19(READ(sample)));
+    gogogo(day19(LOAD(19)), 1624);
+
+    test(56, GeodeSearch(bp1).mostGeodes(32));
+    test(62, GeodeSearch(bp2).mostGeodes(32));
+    gogogo(day19_2(LOAD(19)), 12628);
+}
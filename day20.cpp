@@ -1,88 +1,54 @@
 #include "pch.h"
 #include "harness.h"
 
+#include "indexedsequence.h"
 
-int day20(const stringlist& input)
+
+// mixes the file (multiplied by key) rounds times, and adds up the grove coordinates
+i64 mix(const stringlist& input, i64 key, int rounds)
 {
-    using El = pair<i16, u16>;
-    vector<El> file;
+    indexed_sequence<i64> file;
     file.reserve(input.size());
-    u16 ogix = 0;
-    ranges::transform(input, back_inserter(file), [&ogix](const string& line) { return El{i16(stoi(line)), ogix++}; });
+    for (const string& line : input)
+        file.push_back(stoll(line) * key);
 
-    const u16 numEls = ogix;
-    auto itBegin = begin(file);
-    for (u16 ix = 0; ix<numEls; ++ix)
+    // handles are the original positions, so mixing order is just counting through them
+    const u32 numEls = u32(file.size());
+    const i64 cycle = numEls - 1;     // moving an element round the other n-1 brings it back where it was
+    for (int rep = 0; rep < rounds && numEls > 1; ++rep)   // a file of one is already mixed
     {
-        auto itEl = ranges::find_if(file, [ix](auto& el) { return el.second == ix; });
-        const u32 currLoc = u32(distance(begin(file), itEl));
-        // note: -1 because we jump from N-1=>1 without hitting 0
-        const u32 val = ((10 * (numEls-1)) + itEl->first) % (numEls-1);   // make sure we're always moving to the right
-        u32 newLoc = currLoc + val;   
-        newLoc = newLoc % (numEls - 1);
-
-        if (val && newLoc == 0)
-            newLoc = numEls - 1;
+        for (u32 h = 0; h < numEls; ++h)
+        {
+            const i64 currLoc = i64(file.indexOf(h));
+            i64 newLoc = (currLoc + file.value(h)) % cycle;
+            if (newLoc < 0)
+                newLoc += cycle;
 
-        if (newLoc > currLoc)
-            rotate(itEl, itEl + 1, itBegin + (newLoc + 1));
-        else if (newLoc < currLoc)
-            rotate(itBegin + newLoc, itEl, itEl + 1);
+            file.move(h, size_t(newLoc));
+        }
     }
 
-    auto itZero = ranges::find_if(file, [](auto& el) { return el.first == 0; });
-    u32 zeroLoc = u32(distance(begin(file), itZero));
-    auto el = [=,&file](int ix) -> int
-    {
-        int v = file[(ix + zeroLoc) % numEls].first;
-        return v;
-    };
+    u32 zero = 0;
+    while (zero < numEls && file.value(zero) != 0)
+        ++zero;
+    if (zero == numEls)
+        throw "no zero in file";
 
-    return (el(1000) + el(2000) + el(3000));
+    const size_t zeroLoc = file.indexOf(zero);
+    auto el = [&](size_t ix) { return file[(ix + zeroLoc) % numEls]; };
+
+    return el(1000) + el(2000) + el(3000);
 }
 
 
-i64 day20_2(const stringlist& input)
+int day20(const stringlist& input)
 {
-    using El = pair<i16, u16>;
-    vector<El> file;
-    file.reserve(input.size());
-    u16 ogix = 0;
-    ranges::transform(input, back_inserter(file), [&ogix](const string& line) { return El{ i16(stoi(line)), ogix++ }; });
-
-    const u16 numEls = ogix;
-    constexpr i64 Key = 811589153;
-    const i64 lcd = Key * (numEls - 1);
-    auto itBegin = begin(file);
-    for (int rep = 0; rep < 10; ++rep)
-    {
-        for (u16 ix = 0; ix < numEls; ++ix)
-        {
-            auto itEl = ranges::find_if(file, [ix](auto& el) { return el.second == ix; });
-            const u32 currLoc = u32(distance(begin(file), itEl));
-            // note: -1 because we jump from N-1=>1 without hitting 0
-            const u32 val = i64(2 * lcd + itEl->first*Key) % i64(numEls - 1);   // make sure we're always moving to the right
-            u32 newLoc = currLoc + val;
-            newLoc = newLoc % (numEls - 1);
-
-            if (val && newLoc == 0)
-                newLoc = numEls - 1;
-
-            if (newLoc > currLoc)
-                rotate(itEl, itEl + 1, itBegin + (newLoc + 1));
-            else if (newLoc < currLoc)
-                rotate(itBegin + newLoc, itEl, itEl + 1);
-        }
-    }
-
-    auto itZero = ranges::find_if(file, [](auto& el) { return el.first == 0; });
-    u32 zeroLoc = u32(distance(begin(file), itZero));
-    auto el = [=, &file](int ix) -> i64
-    {
-        return i64(file[(ix + zeroLoc) % numEls].first) * Key;
-    };
+    return int(mix(input, 1, 1));
+}
 
-    return (el(1000) + el(2000) + el(3000));
+i64 day20_2(const stringlist& input)
+{
+    return mix(input, 811589153, 10);
 }
 
 
@@ -98,8 +64,9 @@ R"(1
 4)";
 
     test(3, day20(READ(sample)));
-    nononoD(day20(LOAD(20)));
+    test(0, day20(READ("0")));
+    gogogo(day20(LOAD(20)), 2827);
 
     test(1623178306ll, day20_2(READ(sample)));
-    nononoD(day20_2(LOAD(20)));
-}
\ No newline at end of file
+    gogogo(day20_2(LOAD(20)), 7834270093909ll);
+}
@@ -16,34 +16,6 @@ u32 u32FromStr(const char* s)
 const u32 RootName = u32FromStr("root");
 const u32 HumanName = u32FromStr("humn");
 
-struct NMonkey
-{
-    i64 val=-100000;
-    u32 name=0;
-    u32 monkA=0, monkB=0;
-    char op = '!';
-    bool resolved = false;
-    NMonkey* a = nullptr;
-    NMonkey* b = nullptr;
-
-    NMonkey(const string& str)
-    {
-        name = u32FromStr(str.data());
-
-        if (isdigit(str[6]))
-        {
-            resolved = true;
-            val = atoi(str.data() + 6);
-        }
-        else
-        {
-            monkA = u32FromStr(str.data() + 6);
-            monkB = u32FromStr(str.data() + 13);
-            op = str[11];
-        }
-    }
-};
-
 i64 doOp(i64 a, char op, i64 b)
 {
     switch (op)
@@ -56,117 +28,329 @@ i64 doOp(i64 a, char op, i64 b)
     return numeric_limits<i64>::max();
 }
 
-i64 day21(const stringlist& input)
+// the monkeys compiled down to a straight-line program. every monkey gets a slot, numbered so
+// that a monkey's slot always comes after the slots of the two it listens to; the shouters' slots
+// are filled in up front and the tape then fills in the rest, in order, in one pass
+struct MonkeyOp
 {
-    unordered_map<u32, i64> resolved;
-    deque<NMonkey> unresolved;
-    for (auto& line : input)
+    char op;
+    u32 a, b;
+    u32 dst;
+};
+
+struct MonkeyProgram
+{
+    static constexpr u32 NoOp = numeric_limits<u32>::max();
+
+    vector<i64> slots;
+    vector<MonkeyOp> tape;
+    vector<u32> opForSlot;      // which instruction writes each slot, or NoOp for shouters
+    vector<u32> firstListener;  // slots that read each slot, as compressed rows
+    vector<u32> listeners;
+    u32 root = 0;
+    u32 human = 0;
+
+    void run()
     {
-        NMonkey m(line);
-        if (m.resolved)
-            resolved.try_emplace(m.name, m.val);
-        else
-            unresolved.push_back(m);
+        for (const MonkeyOp& ins : tape)
+            slots[ins.dst] = doOp(slots[ins.a], ins.op, slots[ins.b]);
     }
 
-    while (!unresolved.empty())
+    // every slot that would change if slot did, in tape order
+    const vector<u32>& findDependents(u32 slot)
     {
-        for (auto it=begin(unresolved); it!=end(unresolved); /**/)
+        if (m_mark.size() != slots.size())
+            m_mark.assign(slots.size(), 0);
+        ++m_stamp;
+
+        m_dirty.clear();
+        m_dirty.push_back(slot);
+        m_mark[slot] = m_stamp;
+        for (size_t i = 0; i < m_dirty.size(); ++i)
         {
-            if (resolved.contains(it->monkA) && resolved.contains(it->monkB))
+            const u32 s = m_dirty[i];
+            for (u32 l = firstListener[s]; l < firstListener[s + 1]; ++l)
             {
-                i64 val = doOp(resolved[it->monkA], it->op, resolved[it->monkB]);
-                if (it->name == RootName) [[unlikely]]
-                    return val;
+                const u32 listener = listeners[l];
+                if (m_mark[listener] == m_stamp)
+                    continue;
 
-                resolved.try_emplace(it->name, val);
-                it = unresolved.erase(it);
+                m_mark[listener] = m_stamp;
+                m_dirty.push_back(listener);
             }
-            else
-                ++it;
         }
+
+        // slots are numbered in dependency order, so sorting them is the order to run them in
+        ranges::sort(m_dirty);
+        return m_dirty;
     }
-    return -1;
-}
 
-bool tryResolve(NMonkey* m, auto&& findMonkey)
+    // changes what a shouting monkey shouts, and re-runs just what depends on it
+    void setLeaf(u32 slot, i64 val)
+    {
+        if (opForSlot[slot] != NoOp)
+            throw "that monkey doesn't shout a number";
+
+        slots[slot] = val;
+        for (u32 dirty : findDependents(slot))
+        {
+            if (dirty == slot)
+                continue;
+
+            const MonkeyOp& ins = tape[opForSlot[dirty]];
+            slots[ins.dst] = doOp(slots[ins.a], ins.op, slots[ins.b]);
+        }
+    }
+
+    i64 solveFor(u32 leaf, u32 slot, i64 target);
+
+private:
+    vector<u32> m_mark;
+    u32 m_stamp = 0;
+    vector<u32> m_dirty;
+};
+
+
+// (p*x + q) / (r*x + s) for some unknown x; closed under +-*/ with a constant, which is all a
+// chain of monkeys can do to one number, so solving for x is one division at the end
+struct LinearFraction
 {
-    if (m->resolved)
-        return true;
-    if (m->name == HumanName)
-        return false;
+    i64 p = 1, q = 0, r = 0, s = 1;
 
-    bool aIsResolved = m->a->resolved;
-    if (!aIsResolved)
-        aIsResolved = tryResolve(m->a, findMonkey);
+    static LinearFraction constant(i64 c)   { return { 0, c, 0, 1 }; }
 
-    bool bIsResolved = m->b->resolved;
-    if (!bIsResolved)
-        bIsResolved = tryResolve(m->b, findMonkey);
+    bool isLinear() const   { return r == 0; }
 
-    if (aIsResolved && bIsResolved)
+    void reduce()
     {
-        m->val = doOp(m->a->val, m->op, m->b->val);
-        m->resolved = true;
-        return true;
+        i64 d = gcd(gcd(p, q), gcd(r, s));
+        if (s < 0 || (s == 0 && r < 0))
+            d = -d;
+        if (d != 0 && d != 1)
+        {
+            p /= d; q /= d; r /= d; s /= d;
+        }
     }
+};
 
-    return false;
-}
-
-i64 solveHumanChain(NMonkey* m, i64 target)
+LinearFraction applyOp(const LinearFraction& f, char op, const LinearFraction& g, bool fHasX, bool gHasX)
 {
-    if (m->name == HumanName)
-        return target;
+    LinearFraction out;
+    if (fHasX && gHasX)
+    {
+        // x turns up on both sides; only adding and subtracting straight lines stays a line
+        if ((op != '+' && op != '-') || !f.isLinear() || !g.isLinear())
+            throw "can't solve for a monkey that gets multiplied by itself";
 
-    if (m->a->resolved)
+        const i64 sign = op == '+' ? 1 : -1;
+        out = { f.p * g.s + sign * g.p * f.s, f.q * g.s + sign * g.q * f.s, 0, f.s * g.s };
+    }
+    else if (fHasX)
+    {
+        const i64 c = g.q / g.s;
+        switch (op)
+        {
+        case '+': out = { f.p + c * f.r, f.q + c * f.s, f.r, f.s }; break;
+        case '-': out = { f.p - c * f.r, f.q - c * f.s, f.r, f.s }; break;
+        case '*': out = { f.p * c, f.q * c, f.r, f.s }; break;
+        case '/': out = { f.p, f.q, f.r * c, f.s * c }; break;
+        }
+    }
+    else
     {
-        i64 newTarget = -999999;
-        switch (m->op)
+        const i64 c = f.q / f.s;
+        switch (op)
         {
-        case '+':    newTarget = target - m->a->val; break;
-        case '-':    newTarget = m->a->val - target; break;
-        case '*':    newTarget = target / m->a->val; break;
-        case '/':    newTarget = target / m->a->val; break;
+        case '+': out = { g.p + c * g.r, g.q + c * g.s, g.r, g.s }; break;
+        case '-': out = { c * g.r - g.p, c * g.s - g.q, g.r, g.s }; break;
+        case '*': out = { g.p * c, g.q * c, g.r, g.s }; break;
+        case '/': out = { c * g.r, c * g.s, g.p, g.q }; break;
         }
-        return solveHumanChain(m->b, newTarget);
     }
 
-    i64 newTarget = -999999;
-    switch (m->op)
+    out.reduce();
+    return out;
+}
+
+// what leaf has to shout for slot to come out as target. only the chain from leaf up to slot is
+// looked at; everything off to the side is read from the last run
+i64 MonkeyProgram::solveFor(u32 leaf, u32 slot, i64 target)
+{
+    const vector<u32>& dependents = findDependents(leaf);
+    if (!ranges::binary_search(dependents, slot))
+        throw "that monkey isn't listening to the leaf";
+
+    // dependents is sorted by slot, so these line up with it
+    vector<LinearFraction> fns(dependents.size());
+    auto fnFor = [&](u32 s) -> pair<LinearFraction, bool>
     {
-    case '+':    newTarget = target - m->b->val; break;
-    case '-':    newTarget = target + m->b->val; break;
-    case '*':    newTarget = target / m->b->val; break;
-    case '/':    newTarget = target * m->b->val; break;
+        auto it = ranges::lower_bound(dependents, s);
+        if (it != end(dependents) && *it == s)
+            return { fns[it - begin(dependents)], true };
+        return { LinearFraction::constant(slots[s]), false };
+    };
+
+    for (size_t i = 0; i < dependents.size(); ++i)
+    {
+        const u32 d = dependents[i];
+        if (d == leaf)
+            continue;   // already x
+
+        const MonkeyOp& ins = tape[opForSlot[d]];
+        auto [a, aHasX] = fnFor(ins.a);
+        auto [b, bHasX] = fnFor(ins.b);
+        fns[i] = applyOp(a, ins.op, b, aHasX, bHasX);
+
+        if (d == slot)
+            break;
     }
-    return solveHumanChain(m->a, newTarget);
+
+    // (p*x + q) / (r*x + s) = t  =>  x = (t*s - q) / (p - t*r)
+    const LinearFraction f = fnFor(slot).first;
+    const i64 num = target * f.s - f.q;
+    const i64 den = f.p - target * f.r;
+    if (den == 0 || num % den != 0)
+        throw "no whole number makes that work";
+
+    return num / den;
 }
 
-i64 day21_2(const stringlist& input)
+MonkeyProgram compileMonkeys(const stringlist& input)
 {
-    vector<NMonkey> monkeys;
-    monkeys.reserve(input.size());
-    ranges::transform(input, back_inserter(monkeys), [](auto& s) { return NMonkey(s); });
-    auto findMonkey = [&monkeys](u32 name) -> NMonkey* { return &*ranges::find(monkeys, name, &NMonkey::name); };
+    // look every name up just the once
+    const u32 numMonkeys = u32(input.size());
+    unordered_map<u32, u32> monkeyIxs;
+    monkeyIxs.reserve(numMonkeys);
+    for (u32 i = 0; i < numMonkeys; ++i)
+        monkeyIxs.emplace(u32FromStr(input[i].data()), i);
+
+    constexpr u32 NoMonkey = numeric_limits<u32>::max();
+    struct Monkey
+    {
+        i64 val = 0;
+        u32 a = NoMonkey, b = NoMonkey;
+        char op = 0;
+    };
+    vector<Monkey> monkeys(numMonkeys);
+    for (u32 i = 0; i < numMonkeys; ++i)
+    {
+        const string& line = input[i];
+        Monkey& m = monkeys[i];
+        if (isdigit(line[6]) || line[6] == '-')
+        {
+            m.val = atoll(line.data() + 6);
+        }
+        else
+        {
+            m.a = monkeyIxs.at(u32FromStr(line.data() + 6));
+            m.b = monkeyIxs.at(u32FromStr(line.data() + 13));
+            m.op = line[11];
+        }
+    }
+
+    // number the slots in post-order, so everyone comes after what they listen to
+    vector<u32> slotOf(numMonkeys, NoMonkey);
+    vector<u32> order;
+    order.reserve(numMonkeys);
+    vector<pair<u32, bool>> stack;
+    for (u32 i = 0; i < numMonkeys; ++i)
+    {
+        if (slotOf[i] != NoMonkey)
+            continue;
+
+        stack.emplace_back(i, false);
+        while (!stack.empty())
+        {
+            auto [m, childrenDone] = stack.back();
+            stack.pop_back();
+            if (slotOf[m] != NoMonkey)
+                continue;
+
+            if (childrenDone || monkeys[m].op == 0)
+            {
+                slotOf[m] = u32(order.size());
+                order.push_back(m);
+                continue;
+            }
+
+            stack.emplace_back(m, true);
+            for (u32 child : { monkeys[m].b, monkeys[m].a })
+            {
+                if (slotOf[child] == NoMonkey)
+                    stack.emplace_back(child, false);
+            }
+        }
+    }
+
+    MonkeyProgram prog;
+    prog.slots.resize(numMonkeys);
+    prog.opForSlot.resize(numMonkeys, MonkeyProgram::NoOp);
+    prog.tape.reserve(numMonkeys);
+    for (u32 m : order)
+    {
+        const Monkey& monkey = monkeys[m];
+        if (monkey.op)
+        {
+            prog.opForSlot[slotOf[m]] = u32(prog.tape.size());
+            prog.tape.push_back({ .op = monkey.op, .a = slotOf[monkey.a], .b = slotOf[monkey.b], .dst = slotOf[m] });
+        }
+        else
+        {
+            prog.slots[slotOf[m]] = monkey.val;
+        }
+    }
 
-    for (auto& m : monkeys | views::filter([](auto& m) { return !m.resolved; }))
+    // who's listening to who, for working out what a change upsets
+    prog.firstListener.assign(numMonkeys + 1, 0);
+    for (const MonkeyOp& ins : prog.tape)
+    {
+        ++prog.firstListener[ins.a + 1];
+        ++prog.firstListener[ins.b + 1];
+    }
+    partial_sum(begin(prog.firstListener), end(prog.firstListener), begin(prog.firstListener));
+    prog.listeners.resize(prog.firstListener.back());
+    vector<u32> nextListener(begin(prog.firstListener), end(prog.firstListener) - 1);
+    for (const MonkeyOp& ins : prog.tape)
     {
-        m.a = findMonkey(m.monkA);
-        m.b = findMonkey(m.monkB);
+        prog.listeners[nextListener[ins.a]++] = ins.dst;
+        prog.listeners[nextListener[ins.b]++] = ins.dst;
     }
 
-    NMonkey* root = findMonkey(RootName);
-    NMonkey* human = findMonkey(HumanName);
-    human->resolved = false;
+    prog.root = slotOf[monkeyIxs.at(RootName)];
+    if (auto it = monkeyIxs.find(HumanName); it != end(monkeyIxs))
+        prog.human = slotOf[it->second];
+
+    return prog;
+}
+
+
+i64 day21(const stringlist& input)
+{
+    MonkeyProgram prog = compileMonkeys(input);
+    prog.run();
+    return prog.slots[prog.root];
+}
+
+i64 day21_2(const stringlist& input)
+{
+    MonkeyProgram prog = compileMonkeys(input);
+    prog.run();
+
+    // root wants both sides equal; one of them is waiting on us
+    const MonkeyOp& root = prog.tape[prog.opForSlot[prog.root]];
+    const auto& fromHuman = prog.findDependents(prog.human);
+    const bool aIsHuman = ranges::binary_search(fromHuman, root.a);
+    const u32 humanSide = aIsHuman ? root.a : root.b;
+    const i64 target = prog.slots[aIsHuman ? root.b : root.a];
 
-    tryResolve(root->a, findMonkey);
-    bool aIsHuman = tryResolve(root->b, findMonkey);
+    const i64 shout = prog.solveFor(prog.human, humanSide, target);
 
-    auto humanChain = aIsHuman ? root->a : root->b;
-    i64 target = aIsHuman ? root->b->val : root->a->val;
+    // try it out, which only re-runs the chain from humn up
+    prog.setLeaf(prog.human, shout);
+    if (prog.slots[humanSide] != target)
+        throw "solved for the wrong thing";
 
-    return solveHumanChain(humanChain, target);;
+    return shout;
 }
 
 
@@ -190,8 +374,8 @@ drzm: hmdt - zczc
 hmdt: 32)";
 
     test(152ll, day21(READ(sample)));
-    gogogo(day21(LOAD(21)));
+    gogogo(day21(LOAD(21)), 21120928600114ll);
 
     test(301, day21_2(READ(sample)));
-    gogogo(day21_2(LOAD(21)));
+    gogogo(day21_2(LOAD(21)), 3453748220116ll);
 }
\ No newline at end of file
@@ -7,44 +7,25 @@
 vector<u8> findVisibleTrees(const stringlist& input)
 {
     const u64 w = input.front().size();
-    const u64 h = input.size();
-    vector<u8> visible(w * h, 0);
+    vector<u8> visible(w * input.size(), 0);
 
-    // rows
-    fill(visible.begin(), visible.begin() + w, u8(1));
-    fill(visible.end() - w, visible.end(), u8(1));
-    for (u64 y = 1; (y + 1) < h; ++y)
+    // looking in from each side is just looking in from the left of a rotated view
+    for (u32 turns = 0; turns < 4; ++turns)
     {
-        auto& line = input[y];
-
-        visible[y * w] = 1;
-        visible[(y + 1) * w - 1] = 1;
-
-        for (u64 x = 1; (x + 1) < w; ++x)
+        CharGridView view(input, turns);
+        for (size_t y = 0; y < view.height(); ++y)
         {
-            char tree = line[x];
-
-            bool hiddenLeft = any_of(begin(line), begin(line) + x, [tree](char c) { return c >= tree; });
-            bool hiddenRight = hiddenLeft ? any_of(begin(line) + (x + 1), end(line), [tree](char c) { return c >= tree; }) : false;
-
-            visible[x + y * h] = !(hiddenLeft && hiddenRight);
-        }
-    }
-
-    // cols
-    for (u64 x = 1; (x + 1) < w; ++x)
-    {
-        for (u64 y = 1; (y + 1) < h; ++y)
-        {
-            if (visible[x + y * w])
-                continue;
-
-            char tree = input[y][x];
-
-            bool hiddenTop = any_of(begin(input), begin(input) + y, [tree, x](auto& line) { return line[x] >= tree; });
-            bool hiddenBottom = hiddenTop ? any_of(begin(input) + (y + 1), end(input), [tree, x](auto& line) { return line[x] >= tree; }) : false;
-
-            visible[x + y * h] = !(hiddenTop && hiddenBottom);
+            char tallest = 0;
+            for (size_t x = 0; x < view.width(); ++x)
+            {
+                char tree = view(x, y);
+                if (tree <= tallest)
+                    continue;
+
+                auto [treeX, treeY] = view.source(x, y);
+                visible[treeX + treeY * w] = 1;
+                tallest = tree;
+            }
         }
     }
 
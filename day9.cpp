@@ -2,6 +2,7 @@
 #include "harness.h"
 
 #include "pt2.h"
+#include "sparsegrid.h"
 #include <span>
 
 
@@ -104,9 +105,9 @@ void moveTowards(Pt2i& knot, const Pt2i& target)
 int day9(const stringlist& input)
 {
     Pt2i head{ 0, 0 }, tail{ 0, 0 };
-    unordered_set<Pt2i> visited;
+    sparse_grid<u8> visited;
 
-    visited.insert(tail);
+    visited[tail] = 1;
     for (auto& line : input)
     {
         istringstream is(line);
@@ -119,11 +120,11 @@ int day9(const stringlist& input)
         {
             head += move;
             moveTowards(tail, head);
-            visited.insert(tail);
+            visited[tail] = 1;
         }
     }
 
-    return int(visited.size());
+    return int(visited.count(1));
 }
 
 int day9_2(const stringlist& input)
@@ -133,9 +134,9 @@ int day9_2(const stringlist& input)
     ranges::fill(knots, Pt2i{ 0,0 });
 
     const Pt2i& tail = knots[numKnots - 1];
-    unordered_set<Pt2i> visited;
+    sparse_grid<u8> visited;
 
-    visited.insert(tail);
+    visited[tail] = 1;
     for (auto& line : input)
     {
         istringstream is(line);
@@ -151,11 +152,11 @@ int day9_2(const stringlist& input)
             for (int knot = 1; knot < numKnots; ++knot)
                 moveTowards(knots[knot], knots[knot - 1]);
 
-            visited.insert(tail);
+            visited[tail] = 1;
         }
     }
 
-    return int(visited.size());
+    return int(visited.count(1));
 }
 
 
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <limits>
+#include <span>
+#include <vector>
+
+
+// unweighted directed graph over dense node indices, stored as compressed rows: every node's
+// neighbours sit next to each other in one big array, so walking edges is a linear scan
+template<typename NodeIx = u16>
+class IndexedGraph
+{
+public:
+    using node_index = NodeIx;
+
+    // nodes get their indices in the order they're added, but neighbours can name nodes that
+    // haven't been added yet
+    NodeIx addNode(span<const NodeIx> neighbours)
+    {
+        if (size() >= size_t(numeric_limits<NodeIx>::max())) [[unlikely]]
+            throw "too many nodes for the index type";
+
+        m_edges.insert(end(m_edges), begin(neighbours), end(neighbours));
+        m_firstEdge.push_back(u32(m_edges.size()));
+        return NodeIx(size() - 1);
+    }
+
+    [[nodiscard]] size_t size() const       { return m_firstEdge.size() - 1; }
+
+    span<const NodeIx> neighbours(NodeIx n) const
+    {
+        return span(m_edges).subspan(m_firstEdge[n], m_firstEdge[n + 1] - m_firstEdge[n]);
+    }
+
+    // hop counts from src to every node; Unreachable where there's no way through
+    static constexpr u32 Unreachable = numeric_limits<u32>::max();
+    void findHops(NodeIx src, vector<u32>& hops, vector<NodeIx>& queue) const
+    {
+        hops.assign(size(), Unreachable);
+        queue.clear();
+        queue.reserve(size());
+
+        hops[src] = 0;
+        queue.push_back(src);
+        for (size_t head = 0; head < queue.size(); ++head)
+        {
+            const NodeIx curr = queue[head];
+            const u32 next = hops[curr] + 1;
+            for (NodeIx neigh : neighbours(curr))
+            {
+                if (hops[neigh] != Unreachable)
+                    continue;
+
+                hops[neigh] = next;
+                queue.push_back(neigh);
+            }
+        }
+    }
+
+    // all-pairs hop counts between just the given nodes, as a row-major nodes.size()^2 matrix.
+    // one BFS per node, so O(k(V+E)); anything too far for Cost saturates to its max
+    template<typename Cost>
+    vector<Cost> findHopsBetween(span<const NodeIx> nodes) const
+    {
+        constexpr u32 MaxCost = u32(numeric_limits<Cost>::max());
+
+        const size_t k = nodes.size();
+        vector<Cost> costs(k * k);
+
+        vector<u32> hops;
+        vector<NodeIx> queue;
+        for (size_t a = 0; a < k; ++a)
+        {
+            findHops(nodes[a], hops, queue);
+            for (size_t b = 0; b < k; ++b)
+                costs[a * k + b] = Cost(min(hops[nodes[b]], MaxCost));
+        }
+
+        return costs;
+    }
+
+private:
+    vector<u32> m_firstEdge{ 0 };
+    vector<NodeIx> m_edges;
+};
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "bucketqueue.h"
+#include "pt2.h"
+#include "vector2d.h"
+
+
+struct UnitStepCost
+{
+    u32 operator()(const auto& /*from*/, const auto& /*to*/) const { return 1; }
+};
+
+// A* heuristics: a lower bound on the cost from pos to dest. it has to be consistent (never
+// drop by more than the cost of a step) for the first visit to a cell to be the best one
+struct ZeroHeuristic
+{
+    u32 operator()(const auto& /*pos*/, const auto& /*dest*/) const { return 0; }
+};
+
+struct ManhattanHeuristic
+{
+    u32 operator()(const auto& pos, const auto& dest) const
+    {
+        return u32(abs(pos.x - dest.x) + abs(pos.y - dest.y));
+    }
+};
+
+// A* tie-breaks: which of the cells tied on the lowest estimate gets expanded first
+struct LastPushedFirst {};      // whatever the bucket queue hands back, which is free
+
+// lowest heuristic first. the estimates are tied, so that's the one furthest from the start
+struct LowerHeuristicFirst
+{
+    bool operator()(u32 distA, u32 distB) const { return distA > distB; }
+};
+
+// counters for the last search, for seeing how much a heuristic saves
+struct SearchStats
+{
+    u32 expanded = 0;       // cells popped off the open set
+    u32 pushed = 0;         // cells queued or moved down the queue
+    u32 peakFrontier = 0;   // most cells queued at once
+};
+
+inline ostream& operator<<(ostream& os, const SearchStats& stats)
+{
+    return os << "expanded " << stats.expanded << ", pushed " << stats.pushed << ", peak frontier " << stats.peakFrontier;
+}
+
+// walking a step backwards: for searching out from the destination instead of towards it
+auto reversed(auto canStep)
+{
+    return [canStep](const auto& from, const auto& to) { return canStep(to, from); };
+}
+
+
+// shortest paths over the 4-connected cells of a vector2d (or anything that looks like one).
+// which steps are allowed and what they cost are up to the caller:
+//   canStep(coord from, coord to) -> bool
+//   stepCost(coord from, coord to) -> Distance
+// distances and predecessors live in dense grids the same shape as the map, and all the buffers
+// are kept between searches so running lots of queries doesn't keep hitting the allocator.
+// distances are small integers, so the open set is a bucket queue rather than a heap.
+// by default buckets pop last-in-first-out, so A* ties on f go to the most recently pushed cell,
+// which is usually the deepest one and the one nearest dest; pass a tie-break to choose otherwise
+template<typename Grid, typename Distance = u32>
+class GridSearch
+{
+public:
+    using coord = typename Grid::coord;
+    using coord_el = typename coord::el_type;
+    using distance_type = Distance;
+
+    static constexpr Distance Unreachable = numeric_limits<Distance>::max();
+    static constexpr coord NoCoord{ numeric_limits<coord_el>::max(), numeric_limits<coord_el>::max() };
+    static constexpr coord Directions[] = { {1,0}, {0,1}, {-1,0}, {0,-1} };
+
+    explicit GridSearch(const Grid& grid)
+        : m_grid(grid)
+        , m_dist(grid.width(), grid.height(), Unreachable)
+        , m_bestPath(grid.width(), grid.height(), NoCoord)
+        , m_open(grid.size())
+    {
+        m_dist.setOffset(grid.offset());
+        m_bestPath.setOffset(grid.offset());
+    }
+
+    template<typename CanStep, typename StepCost = UnitStepCost>
+    Distance findShortestPath(const coord& start, const coord& dest, const CanStep& canStep, const StepCost& stepCost = {})
+    {
+        return findShortestPath(span<const coord>(&start, 1), dest, canStep, stepCost);
+    }
+
+    // distance to dest from whichever of starts is nearest
+    template<typename CanStep, typename StepCost = UnitStepCost>
+    Distance findShortestPath(span<const coord> starts, const coord& dest, const CanStep& canStep, const StepCost& stepCost = {})
+    {
+        seed(starts, dest, ZeroHeuristic{});
+        return run(dest, canStep, stepCost, ZeroHeuristic{});
+    }
+
+    // same as findShortestPath, but heads towards dest first. heuristic(coord pos, coord dest)
+    // must never overestimate, which Manhattan doesn't as long as every step costs at least 1
+    template<typename CanStep, typename Heuristic = ManhattanHeuristic, typename StepCost = UnitStepCost, typename TieBreak = LastPushedFirst>
+    Distance findShortestPathAStar(const coord& start, const coord& dest, const CanStep& canStep, const Heuristic& heuristic = {}, const StepCost& stepCost = {}, const TieBreak& tieBreak = {})
+    {
+        return findShortestPathAStar(span<const coord>(&start, 1), dest, canStep, heuristic, stepCost, tieBreak);
+    }
+
+    template<typename CanStep, typename Heuristic = ManhattanHeuristic, typename StepCost = UnitStepCost, typename TieBreak = LastPushedFirst>
+    Distance findShortestPathAStar(span<const coord> starts, const coord& dest, const CanStep& canStep, const Heuristic& heuristic = {}, const StepCost& stepCost = {}, const TieBreak& tieBreak = {})
+    {
+        seed(starts, dest, heuristic);
+        return run(dest, canStep, stepCost, heuristic, tieBreak);
+    }
+
+    // distance from the nearest of starts to every reachable cell. flood from the destination
+    // with reversed(canStep) and the one field answers "how far is it to there" for every cell
+    template<typename CanStep, typename StepCost = UnitStepCost>
+    const vector2d<Distance, coord_el>& findDistanceField(span<const coord> starts, const CanStep& canStep, const StepCost& stepCost = {})
+    {
+        seed(starts, NoCoord, ZeroHeuristic{});
+        run(NoCoord, canStep, stepCost, ZeroHeuristic{});
+        return m_dist;
+    }
+
+    template<typename CanStep, typename StepCost = UnitStepCost>
+    const vector2d<Distance, coord_el>& findDistanceField(const coord& start, const CanStep& canStep, const StepCost& stepCost = {})
+    {
+        return findDistanceField(span<const coord>(&start, 1), canStep, stepCost);
+    }
+
+    // results of the last search
+    const vector2d<Distance, coord_el>& distances() const   { return m_dist; }
+    const vector2d<coord, coord_el>& bestPath() const       { return m_bestPath; }
+    const SearchStats& stats() const                        { return m_stats; }
+
+    // dest back to whichever start the search came from, or empty if we never got there
+    vector<coord> pathTo(coord dest) const
+    {
+        vector<coord> path;
+        if (m_dist[dest] == Unreachable)
+            return path;
+
+        for (; dest != NoCoord; dest = m_bestPath[dest])
+            path.push_back(dest);
+        return path;
+    }
+
+private:
+    void seed(span<const coord> starts, const coord& dest, const auto& heuristic)
+    {
+        m_dist.fill(Unreachable);
+        m_bestPath.fill(NoCoord);
+        m_open.clear();
+        m_stats = {};
+
+        for (const coord& start : starts)
+            relax(start, NoCoord, 0, Distance(heuristic(start, dest)));
+    }
+
+    template<typename TieBreak = LastPushedFirst>
+    Distance run(const coord& dest, const auto& canStep, const auto& stepCost, const auto& heuristic, const TieBreak& tieBreak = {})
+    {
+        while (!m_open.empty())
+        {
+            u32 nodeId;
+            if constexpr (is_same_v<TieBreak, LastPushedFirst>)
+                nodeId = m_open.pop();
+            else
+                nodeId = m_open.pop([&](u32 a, u32 b) { return tieBreak(m_dist[coordOf(a)], m_dist[coordOf(b)]); });
+
+            const coord nodePos = coordOf(nodeId);
+            const Distance nodeDist = m_dist[nodePos];
+            const Distance nodeEstimate = m_open.priority(nodeId);
+            ++m_stats.expanded;
+
+            if (nodePos == dest)
+                return nodeDist;
+
+            for (const coord& dir : Directions)
+            {
+                coord neighbourPos = nodePos + dir;
+                if (!m_grid.isInMap(neighbourPos) || !canStep(nodePos, neighbourPos))
+                    continue;
+
+                const Distance dist = Distance(nodeDist + stepCost(nodePos, neighbourPos));
+                if (dist >= m_dist[neighbourPos])
+                    continue;
+
+                // never let the estimate go backwards, or the bucket queue would be handed a
+                // priority below the one it just popped
+                relax(neighbourPos, nodePos, dist, max(nodeEstimate, Distance(dist + heuristic(neighbourPos, dest))));
+            }
+        }
+
+        return Unreachable;
+    }
+
+    void relax(const coord& pos, const coord& from, Distance dist, Distance estimate)
+    {
+        if (dist >= m_dist[pos])
+            return;
+
+        m_dist[pos] = dist;
+        m_bestPath[pos] = from;
+        m_open.push_or_decrease(idOf(pos), estimate);
+
+        ++m_stats.pushed;
+        m_stats.peakFrontier = max(m_stats.peakFrontier, u32(m_open.size()));
+    }
+
+    u32 idOf(const coord& c) const
+    {
+        const coord local = c - m_grid.offset();
+        return u32(local.x) + u32(local.y) * m_grid.width();
+    }
+    coord coordOf(u32 id) const
+    {
+        const u32 w = m_grid.width();
+        return m_grid.offset() + coord{ coord_el(id % w), coord_el(id / w) };
+    }
+
+    const Grid& m_grid;
+    vector2d<Distance, coord_el> m_dist;
+    vector2d<coord, coord_el> m_bestPath;
+    bucket_queue<Distance> m_open;
+    SearchStats m_stats;
+};
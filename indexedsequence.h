@@ -0,0 +1,191 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+
+
+// a list you can index into, find the position of, and move things around in, all in O(log n).
+// it's an implicit treap: a randomly balanced tree ordered by position rather than by key, where
+// each node knows how many nodes are under it so positions fall out of the subtree sizes.
+// every value gets a handle when it's added which stays with it however much it moves, and the
+// nodes live in one vector indexed by handle, so handle -> node is free and nothing is allocated
+// once the sequence is built
+template<typename T>
+class indexed_sequence
+{
+public:
+    using value_type = T;
+    using handle = u32;
+
+    static constexpr handle NoNode = numeric_limits<handle>::max();
+
+    void reserve(size_t count)  { m_nodes.reserve(count); }
+
+    [[nodiscard]] size_t size() const   { return sizeOf(m_root); }
+    [[nodiscard]] bool empty() const    { return m_root == NoNode; }
+
+    // handles are given out in order, so the nth value added is handle n
+    handle push_back(const value_type& val)
+    {
+        const handle h = handle(m_nodes.size());
+        m_nodes.push_back({ .val = val, .priority = nextPriority() });
+        m_root = merge(m_root, h);
+        m_nodes[m_root].parent = NoNode;
+        return h;
+    }
+
+    value_type& value(handle h)             { return m_nodes[h].val; }
+    const value_type& value(handle h) const { return m_nodes[h].val; }
+
+    // where h currently sits in the sequence
+    size_t indexOf(handle h) const
+    {
+        size_t ix = sizeOf(m_nodes[h].left);
+        for (handle child = h, parent = m_nodes[h].parent; parent != NoNode; child = parent, parent = m_nodes[parent].parent)
+        {
+            if (m_nodes[parent].right == child)
+                ix += sizeOf(m_nodes[parent].left) + 1;
+        }
+        return ix;
+    }
+
+    // whatever's at position ix
+    handle at(size_t ix) const
+    {
+        handle n = m_root;
+        for (;;)
+        {
+            const size_t leftSize = sizeOf(m_nodes[n].left);
+            if (ix < leftSize)
+            {
+                n = m_nodes[n].left;
+            }
+            else if (ix == leftSize)
+            {
+                return n;
+            }
+            else
+            {
+                ix -= leftSize + 1;
+                n = m_nodes[n].right;
+            }
+        }
+    }
+
+    const value_type& operator[](size_t ix) const   { return value(at(ix)); }
+
+    // takes h out of the sequence, but keeps it around to be put back with insert()
+    void erase(handle h)
+    {
+        auto [before, rest] = split(m_root, indexOf(h));
+        m_root = merge(before, split(rest, 1).second);
+        if (m_root != NoNode)
+            m_nodes[m_root].parent = NoNode;
+    }
+
+    // puts an erased h back so that it ends up at position ix
+    void insert(size_t ix, handle h)
+    {
+        auto [before, after] = split(m_root, ix);
+        m_root = merge(merge(before, h), after);
+        m_nodes[m_root].parent = NoNode;
+    }
+
+    void move(handle h, size_t newIx)
+    {
+        erase(h);
+        insert(newIx, h);
+    }
+
+private:
+    struct Node
+    {
+        value_type val;
+        u32 priority;
+        u32 size = 1;
+        handle left = NoNode;
+        handle right = NoNode;
+        handle parent = NoNode;
+    };
+
+    u32 sizeOf(handle n) const  { return n == NoNode ? 0 : m_nodes[n].size; }
+
+    void setLeft(handle n, handle child)
+    {
+        m_nodes[n].left = child;
+        if (child != NoNode)
+            m_nodes[child].parent = n;
+    }
+    void setRight(handle n, handle child)
+    {
+        m_nodes[n].right = child;
+        if (child != NoNode)
+            m_nodes[child].parent = n;
+    }
+    void update(handle n)
+    {
+        m_nodes[n].size = 1 + sizeOf(m_nodes[n].left) + sizeOf(m_nodes[n].right);
+    }
+
+    // first count nodes of the tree under n, and the rest. parents of the two roots aren't fixed
+    pair<handle, handle> split(handle n, size_t count)
+    {
+        if (n == NoNode)
+            return { NoNode, NoNode };
+
+        const size_t leftSize = sizeOf(m_nodes[n].left);
+        if (count <= leftSize)
+        {
+            auto [lo, hi] = split(m_nodes[n].left, count);
+            setLeft(n, hi);
+            update(n);
+            if (lo != NoNode)
+                m_nodes[lo].parent = NoNode;
+            return { lo, n };
+        }
+        else
+        {
+            auto [lo, hi] = split(m_nodes[n].right, count - leftSize - 1);
+            setRight(n, lo);
+            update(n);
+            if (hi != NoNode)
+                m_nodes[hi].parent = NoNode;
+            return { n, hi };
+        }
+    }
+
+    // everything in a followed by everything in b
+    handle merge(handle a, handle b)
+    {
+        if (a == NoNode)
+            return b;
+        if (b == NoNode)
+            return a;
+
+        if (m_nodes[a].priority > m_nodes[b].priority)
+        {
+            setRight(a, merge(m_nodes[a].right, b));
+            update(a);
+            return a;
+        }
+        else
+        {
+            setLeft(b, merge(a, m_nodes[b].left));
+            update(b);
+            return b;
+        }
+    }
+
+    // xorshift; a treap only needs its priorities to look random
+    u32 nextPriority()
+    {
+        m_seed ^= m_seed << 13;
+        m_seed ^= m_seed >> 17;
+        m_seed ^= m_seed << 5;
+        return m_seed;
+    }
+
+    vector<Node> m_nodes;
+    handle m_root = NoNode;
+    u32 m_seed = 2463534242;
+};
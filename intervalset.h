@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+// set of integers stored as sorted, disjoint, closed ranges [lo, hi]. inserts just get appended,
+// and the sort + merge happens once on the next query, so building a set from a pile of ranges is
+// one sort rather than a shuffle per insert. clear() keeps the storage, so reuse one per thread
+// for per-row work and it stops allocating after the first few rows
+template<typename T>
+class IntervalSet
+{
+public:
+    struct Interval
+    {
+        T lo;
+        T hi;
+
+        T length() const    { return hi - lo + 1; }
+    };
+
+    void clear()
+    {
+        m_intervals.clear();
+        m_sorted = true;
+    }
+
+    void reserve(size_t count)  { m_intervals.reserve(count); }
+
+    void insert(T lo, T hi)
+    {
+        if (lo > hi)
+            return;
+
+        if (m_sorted && !m_intervals.empty() && reaches(m_intervals.back().hi, lo))
+            m_sorted = false;
+
+        m_intervals.push_back({ lo, hi });
+    }
+
+    void insert(T point)        { insert(point, point); }
+
+    void subtract(T lo, T hi)
+    {
+        if (lo > hi)
+            return;
+
+        normalise();
+
+        // first interval that reaches lo
+        auto it = ranges::lower_bound(m_intervals, lo, {}, &Interval::hi);
+        if (it == end(m_intervals) || it->lo > hi)
+            return;
+
+        // cutting out of the middle leaves two pieces. it->hi > hi and it->lo < lo, so neither
+        // hi + 1 nor lo - 1 can overflow here or below
+        if (it->lo < lo && it->hi > hi)
+        {
+            const Interval right{ hi + 1, it->hi };
+            it->hi = lo - 1;
+            m_intervals.insert(it + 1, right);
+            return;
+        }
+
+        if (it->lo < lo)
+        {
+            it->hi = lo - 1;
+            ++it;
+        }
+
+        // everything from here that's entirely inside goes, and the last one may lose its start
+        auto last = it;
+        while (last != end(m_intervals) && last->hi <= hi)
+            ++last;
+        if (last != end(m_intervals) && last->lo <= hi)
+            last->lo = hi + 1;
+
+        m_intervals.erase(it, last);
+    }
+
+    void subtract(T point)      { subtract(point, point); }
+
+    [[nodiscard]] bool contains(T point)
+    {
+        normalise();
+        auto it = ranges::lower_bound(m_intervals, point, {}, &Interval::hi);
+        return it != end(m_intervals) && it->lo <= point;
+    }
+
+    // how many integers are in the set
+    [[nodiscard]] T coveredLength()
+    {
+        normalise();
+        T total{};
+        for (const Interval& i : m_intervals)
+            total += i.length();
+        return total;
+    }
+
+    // the lowest point in [lo, hi] that isn't in the set, if there is one
+    [[nodiscard]] optional<T> firstGap(T lo, T hi)
+    {
+        normalise();
+        auto it = ranges::lower_bound(m_intervals, lo, {}, &Interval::hi);
+        if (it == end(m_intervals) || it->lo > lo)
+            return lo <= hi ? optional<T>(lo) : nullopt;
+
+        // merged intervals never touch, so the next point after this one is a gap (and it->hi < hi,
+        // so there is a next point)
+        return it->hi < hi ? optional<T>(it->hi + 1) : nullopt;
+    }
+
+    [[nodiscard]] bool empty()
+    {
+        return m_intervals.empty();
+    }
+
+    [[nodiscard]] span<const Interval> intervals()
+    {
+        normalise();
+        return m_intervals;
+    }
+
+private:
+    // whether an interval ending at hi overlaps or touches one starting at lo, without working
+    // out hi + 1 when hi is already as big as T goes
+    static bool reaches(T hi, T lo)
+    {
+        return hi >= lo || hi + 1 == lo;
+    }
+
+    // sort and merge in place; ranges that touch are merged as well as ones that overlap
+    void normalise()
+    {
+        if (m_sorted)
+            return;
+
+        ranges::sort(m_intervals, {}, &Interval::lo);
+
+        auto out = begin(m_intervals);
+        for (auto it = out + 1; it != end(m_intervals); ++it)
+        {
+            if (reaches(out->hi, it->lo))
+                out->hi = max(out->hi, it->hi);
+            else
+                *++out = *it;
+        }
+        m_intervals.erase(out + 1, end(m_intervals));
+        m_sorted = true;
+    }
+
+    vector<Interval> m_intervals;
+    bool m_sorted = true;
+};
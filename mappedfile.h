@@ -0,0 +1,105 @@
+#pragma once
+
+#include "harness.h"
+
+#include <string_view>
+
+
+// ----- memory mapped files -----
+//
+// maps a whole file into the address space copy-on-write, so callers can scribble on the
+// view (eg. replacing 'S' with 'a' in a heightmap) without the change ever reaching disk
+class MappedFile
+{
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const string& fname)
+    {
+        m_file = CreateFileA(fname.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+            throw string("couldn't open file " + fname);
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size))
+        {
+            close();
+            throw string("couldn't discover size of " + fname);
+        }
+        m_size = size_t(size.QuadPart);
+        if (m_size == 0)
+            return;     // can't map an empty file, but an empty view is fine
+
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (!m_mapping)
+        {
+            close();
+            throw string("couldn't create mapping for " + fname);
+        }
+
+        m_data = static_cast<char*>(MapViewOfFile(m_mapping, FILE_MAP_COPY, 0, 0, 0));
+        if (!m_data)
+        {
+            close();
+            throw string("couldn't map view of " + fname);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+    {
+        swap(other);
+    }
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            swap(other);
+        }
+        return *this;
+    }
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    [[nodiscard]] char* data()                  { return m_data; }
+    [[nodiscard]] const char* data() const      { return m_data; }
+    [[nodiscard]] size_t size() const           { return m_size; }
+    [[nodiscard]] string_view view() const      { return { m_data, m_size }; }
+
+private:
+    void swap(MappedFile& other) noexcept
+    {
+        std::swap(m_file, other.m_file);
+        std::swap(m_mapping, other.m_mapping);
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+    }
+
+    void close()
+    {
+        if (m_data)
+            UnmapViewOfFile(m_data);
+        if (m_mapping)
+            CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE)
+            CloseHandle(m_file);
+
+        m_file = INVALID_HANDLE_VALUE;
+        m_mapping = nullptr;
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+    char* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+#define MAPFILE(day)    MappedFile("data/day" #day ".txt")
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <array>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "pt2.h"
+#include "pt3.h"
+
+
+// ----- structure-of-arrays point lists -----
+//
+// each axis lives in its own contiguous array, so the batch kernels below are straight loops over
+// plain ints with no gathers and no branches, which the compiler can vectorise (we build with AVX2)
+
+namespace soa
+{
+template<typename T>
+void minmax(span<const T> vals, T& lo, T& hi)
+{
+    T l = numeric_limits<T>::max();
+    T h = numeric_limits<T>::lowest();
+    for (T v : vals)
+    {
+        l = v < l ? v : l;
+        h = v > h ? v : h;
+    }
+    lo = l;
+    hi = h;
+}
+
+template<typename T>
+void add(span<T> vals, T d)
+{
+    for (T& v : vals)
+        v = T(v + d);
+}
+
+// out[i] += |vals[i] - target|
+template<typename T, typename TOut>
+void accumulateAbsDiff(span<const T> vals, T target, span<TOut> out)
+{
+    const T* __restrict src = vals.data();
+    TOut* __restrict dst = out.data();
+    const size_t n = vals.size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        const TOut d = TOut(src[i]) - TOut(target);
+        dst[i] += d < 0 ? -d : d;
+    }
+}
+
+// out[i] += |a[i] - b[i]|
+template<typename T, typename TOut>
+void accumulateAbsDiff(span<const T> a, span<const T> b, span<TOut> out)
+{
+    const T* __restrict srcA = a.data();
+    const T* __restrict srcB = b.data();
+    TOut* __restrict dst = out.data();
+    const size_t n = a.size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        const TOut d = TOut(srcA[i]) - TOut(srcB[i]);
+        dst[i] += d < 0 ? -d : d;
+    }
+}
+} // soa
+
+
+template<typename T, size_t Dims>
+class points_soa_base
+{
+public:
+    using el_type = T;
+    static constexpr size_t dims = Dims;
+
+    void reserve(size_t n)
+    {
+        for (auto& axis : m_axes)
+            axis.reserve(n);
+    }
+    void clear()
+    {
+        for (auto& axis : m_axes)
+            axis.clear();
+    }
+
+    [[nodiscard]] size_t size() const       { return m_axes[0].size(); }
+    [[nodiscard]] bool empty() const        { return m_axes[0].empty(); }
+
+    [[nodiscard]] span<const T> axis(size_t a) const    { return m_axes[a]; }
+    [[nodiscard]] span<T> axis(size_t a)                { return m_axes[a]; }
+
+protected:
+    // out[i] = sum of |axis - target| over every axis
+    template<typename TOut>
+    void manhattanTo(const array<T, Dims>& target, span<TOut> out) const
+    {
+        if (out.size() < size()) [[unlikely]]
+            throw "manhattan output is too small";
+
+        fill_n(out.data(), size(), TOut(0));
+        for (size_t a = 0; a < Dims; ++a)
+            soa::accumulateAbsDiff(axis(a), target[a], out);
+    }
+
+    // out[i] = manhattan distance between our point i and other's point i
+    template<typename TOut>
+    void manhattanTo(const points_soa_base& other, span<TOut> out) const
+    {
+        if (other.size() != size() || out.size() < size()) [[unlikely]]
+            throw "mismatched point lists";
+
+        fill_n(out.data(), size(), TOut(0));
+        for (size_t a = 0; a < Dims; ++a)
+            soa::accumulateAbsDiff(axis(a), other.axis(a), out);
+    }
+
+    array<vector<T>, Dims> m_axes;
+};
+
+
+template<typename Pt>
+class PointsSoA;
+
+template<typename T>
+class PointsSoA<Pt2<T>> : public points_soa_base<T, 2>
+{
+public:
+    using point_type = Pt2<T>;
+    using base = points_soa_base<T, 2>;
+
+    void push_back(const point_type& p)
+    {
+        xs().push_back(p.x);
+        ys().push_back(p.y);
+    }
+
+    point_type operator[](size_t i) const   { return { this->m_axes[0][i], this->m_axes[1][i] }; }
+
+    vector<T>& xs()                         { return this->m_axes[0]; }
+    vector<T>& ys()                         { return this->m_axes[1]; }
+    const vector<T>& xs() const             { return this->m_axes[0]; }
+    const vector<T>& ys() const             { return this->m_axes[1]; }
+
+    // inclusive {lo, hi} corners; only meaningful when there are some points
+    pair<point_type, point_type> bounds() const
+    {
+        point_type lo, hi;
+        soa::minmax(this->axis(0), lo.x, hi.x);
+        soa::minmax(this->axis(1), lo.y, hi.y);
+        return { lo, hi };
+    }
+
+    void translate(const point_type& d)
+    {
+        soa::add(this->axis(0), d.x);
+        soa::add(this->axis(1), d.y);
+    }
+
+    template<typename TOut>
+    void manhattanTo(const point_type& p, span<TOut> out) const     { base::manhattanTo({ p.x, p.y }, out); }
+    template<typename TOut>
+    void manhattanTo(const PointsSoA& other, span<TOut> out) const  { base::manhattanTo(other, out); }
+
+    // out[i] = vertical distance from point i to row y
+    template<typename TOut>
+    void distanceToRow(T y, span<TOut> out) const
+    {
+        if (out.size() < this->size()) [[unlikely]]
+            throw "row distance output is too small";
+
+        fill_n(out.data(), this->size(), TOut(0));
+        soa::accumulateAbsDiff(this->axis(1), y, out);
+    }
+};
+
+template<typename T>
+class PointsSoA<Pt3<T>> : public points_soa_base<T, 3>
+{
+public:
+    using point_type = Pt3<T>;
+    using base = points_soa_base<T, 3>;
+
+    void push_back(const point_type& p)
+    {
+        xs().push_back(p.x);
+        ys().push_back(p.y);
+        zs().push_back(p.z);
+    }
+
+    point_type operator[](size_t i) const   { return { this->m_axes[0][i], this->m_axes[1][i], this->m_axes[2][i] }; }
+
+    vector<T>& xs()                         { return this->m_axes[0]; }
+    vector<T>& ys()                         { return this->m_axes[1]; }
+    vector<T>& zs()                         { return this->m_axes[2]; }
+    const vector<T>& xs() const             { return this->m_axes[0]; }
+    const vector<T>& ys() const             { return this->m_axes[1]; }
+    const vector<T>& zs() const             { return this->m_axes[2]; }
+
+    // inclusive {lo, hi} corners; only meaningful when there are some points
+    pair<point_type, point_type> bounds() const
+    {
+        point_type lo, hi;
+        soa::minmax(this->axis(0), lo.x, hi.x);
+        soa::minmax(this->axis(1), lo.y, hi.y);
+        soa::minmax(this->axis(2), lo.z, hi.z);
+        return { lo, hi };
+    }
+
+    void translate(const point_type& d)
+    {
+        soa::add(this->axis(0), d.x);
+        soa::add(this->axis(1), d.y);
+        soa::add(this->axis(2), d.z);
+    }
+
+    template<typename TOut>
+    void manhattanTo(const point_type& p, span<TOut> out) const     { base::manhattanTo({ p.x, p.y, p.z }, out); }
+    template<typename TOut>
+    void manhattanTo(const PointsSoA& other, span<TOut> out) const  { base::manhattanTo(other, out); }
+};
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <span>
+#include <vector>
+
+
+#define CHECKED_RINGBUFFERx
+
+
+// ----- ring buffers -----
+//
+// all of these have power-of-two capacities and free-running front/back counters, so wrapping
+// is a mask rather than a %, and full vs empty is just (back - front) without a wasted slot
+
+namespace ringbuf
+{
+// copy vals into buf starting at logical position pos, in at most two runs
+template<typename T>
+void copyIn(T* buf, u32 capacity, u32 pos, span<const T> vals)
+{
+    const u32 start = pos & (capacity - 1);
+    const u32 firstRun = min(u32(vals.size()), capacity - start);
+    copy_n(vals.data(), firstRun, buf + start);
+    copy_n(vals.data() + firstRun, vals.size() - firstRun, buf);
+}
+
+// copy out.size() elements from logical position pos of buf, in at most two runs
+template<typename T>
+void copyOut(const T* buf, u32 capacity, u32 pos, span<T> out)
+{
+    const u32 start = pos & (capacity - 1);
+    const u32 firstRun = min(u32(out.size()), capacity - start);
+    copy_n(buf + start, firstRun, out.data());
+    copy_n(buf, out.size() - firstRun, out.data() + firstRun);
+}
+} // ringbuf
+
+
+template<typename T, size_t N>
+class fixed_ring_buffer
+{
+public:
+    using value_type = T;
+    static constexpr size_t capacity = N;
+    static_assert(has_single_bit(N), "ring buffer capacity must be a power of two");
+
+    const value_type& front() const
+    {
+#ifdef CHECKED_RINGBUFFER
+        if (empty()) [[unlikely]]
+            throw "can't read from an empty ringbuf";
+#endif
+
+        return m_buf[m_front & Mask];
+    }
+
+    [[nodiscard]] bool empty() const    { return m_front == m_back; }
+    [[nodiscard]] bool full() const     { return size() == capacity; }
+    [[nodiscard]] u32 size() const      { return m_back - m_front; }
+
+
+    void push_back(const value_type& val)
+    {
+#ifdef CHECKED_RINGBUFFER
+        if (full()) [[unlikely]]
+            throw "can't push onto a full ringbuf";
+#endif
+
+        m_buf[m_back & Mask] = val;
+        ++m_back;
+    }
+
+    void pop_front()
+    {
+#ifdef CHECKED_RINGBUFFER
+        if (empty()) [[unlikely]]
+            throw "can't pop from an empty ringbuf";
+#endif
+
+        ++m_front;
+    }
+
+    // pushes as many of vals as will fit, returns how many that was
+    size_t push_back(span<const value_type> vals)
+    {
+        const u32 count = min(u32(vals.size()), u32(capacity) - size());
+        ringbuf::copyIn(m_buf, u32(capacity), m_back, vals.first(count));
+        m_back += count;
+        return count;
+    }
+
+    // pops as many as are available into out, returns how many that was
+    size_t pop_front(span<value_type> out)
+    {
+        const u32 count = min(u32(out.size()), size());
+        ringbuf::copyOut(m_buf, u32(capacity), m_front, out.first(count));
+        m_front += count;
+        return count;
+    }
+
+private:
+    static constexpr u32 Mask = u32(capacity - 1);
+
+    value_type m_buf[capacity];
+    u32 m_back = 0;
+    u32 m_front = 0;
+};
+
+
+// same as fixed_ring_buffer, but doubles in size instead of filling up
+template<typename T>
+class ring_buffer
+{
+public:
+    using value_type = T;
+
+    ring_buffer() = default;
+    explicit ring_buffer(u32 initialCapacity)
+    {
+        reserve(initialCapacity);
+    }
+
+    const value_type& front() const
+    {
+#ifdef CHECKED_RINGBUFFER
+        if (empty()) [[unlikely]]
+            throw "can't read from an empty ringbuf";
+#endif
+
+        return m_buf[m_front & m_mask];
+    }
+
+    [[nodiscard]] bool empty() const        { return m_front == m_back; }
+    [[nodiscard]] u32 size() const          { return m_back - m_front; }
+    [[nodiscard]] u32 capacity() const      { return u32(m_buf.size()); }
+
+    void reserve(u32 count)
+    {
+        if (count > capacity())
+            regrow(bit_ceil(count));
+    }
+
+
+    void push_back(const value_type& val)
+    {
+        if (size() == capacity()) [[unlikely]]
+            regrow(max(MinCapacity, capacity() * 2));
+
+        m_buf[m_back & m_mask] = val;
+        ++m_back;
+    }
+
+    void pop_front()
+    {
+#ifdef CHECKED_RINGBUFFER
+        if (empty()) [[unlikely]]
+            throw "can't pop from an empty ringbuf";
+#endif
+
+        ++m_front;
+    }
+
+    void push_back(span<const value_type> vals)
+    {
+        reserve(size() + u32(vals.size()));
+        ringbuf::copyIn(m_buf.data(), capacity(), m_back, vals);
+        m_back += u32(vals.size());
+    }
+
+    // pops as many as are available into out, returns how many that was
+    size_t pop_front(span<value_type> out)
+    {
+        const u32 count = min(u32(out.size()), size());
+        ringbuf::copyOut(m_buf.data(), capacity(), m_front, out.first(count));
+        m_front += count;
+        return count;
+    }
+
+private:
+    static constexpr u32 MinCapacity = 16;
+
+    void regrow(u32 newCapacity)
+    {
+        vector<value_type> newBuf(newCapacity);
+        if (!m_buf.empty())
+            ringbuf::copyOut(m_buf.data(), capacity(), m_front, span(newBuf).first(size()));
+
+        m_back = size();
+        m_front = 0;
+        m_mask = newCapacity - 1;
+        m_buf.swap(newBuf);
+    }
+
+    vector<value_type> m_buf;
+    u32 m_mask = 0;
+    u32 m_back = 0;
+    u32 m_front = 0;
+};
+
+
+// lock-free single-producer/single-consumer ring. one thread may push and one other thread may
+// pop at the same time; each side keeps a cached copy of the other's counter so it only touches
+// the other side's cache line when it looks full/empty
+template<typename T, size_t N>
+class spsc_ring_buffer
+{
+public:
+    using value_type = T;
+    static constexpr size_t capacity = N;
+    static_assert(has_single_bit(N), "ring buffer capacity must be a power of two");
+
+    // producer side
+    bool try_push(const value_type& val)
+    {
+        return try_push(span<const value_type>(&val, 1)) == 1;
+    }
+
+    size_t try_push(span<const value_type> vals)
+    {
+        const u32 back = m_back.load(memory_order_relaxed);
+        if (u32(capacity) - (back - m_cachedFront) < vals.size())
+            m_cachedFront = m_front.load(memory_order_acquire);
+
+        const u32 count = min(u32(vals.size()), u32(capacity) - (back - m_cachedFront));
+        ringbuf::copyIn(m_buf, u32(capacity), back, vals.first(count));
+        m_back.store(back + count, memory_order_release);
+        return count;
+    }
+
+    // consumer side
+    bool try_pop(value_type& val)
+    {
+        return try_pop(span<value_type>(&val, 1)) == 1;
+    }
+
+    size_t try_pop(span<value_type> out)
+    {
+        const u32 front = m_front.load(memory_order_relaxed);
+        if (m_cachedBack - front < out.size())
+            m_cachedBack = m_back.load(memory_order_acquire);
+
+        const u32 count = min(u32(out.size()), m_cachedBack - front);
+        ringbuf::copyOut(m_buf, u32(capacity), front, out.first(count));
+        m_front.store(front + count, memory_order_release);
+        return count;
+    }
+
+    // only a snapshot, as the other side can be changing it
+    [[nodiscard]] u32 size_approx() const
+    {
+        return m_back.load(memory_order_acquire) - m_front.load(memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t CacheLine = 64;
+
+    alignas(CacheLine) atomic<u32> m_back{ 0 };
+    u32 m_cachedFront = 0;      // producer's view of m_front
+
+    alignas(CacheLine) atomic<u32> m_front{ 0 };
+    u32 m_cachedBack = 0;       // consumer's view of m_back
+
+    alignas(CacheLine) value_type m_buf[capacity];
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <unordered_map>
+
+#include "pt2.h"
+
+
+// an unbounded 2d grid made of fixed 64x64 chunks that only get allocated once something is
+// written into them. lookups go through a one-entry cache of the last chunk touched (hit or miss),
+// so walks that stay local - which is nearly all of them - don't pay for a hash per cell.
+// NB. the cache makes even const reads unsafe to share between threads
+template<typename T, typename CoordEl = int>
+class sparse_grid
+{
+public:
+    using value_type = T;
+    using coord = Pt2<CoordEl>;
+
+    static constexpr i32 ChunkShift = 6;
+    static constexpr i32 ChunkSize = 1 << ChunkShift;
+    static constexpr i32 ChunkMask = ChunkSize - 1;
+
+    struct Chunk
+    {
+        coord origin;
+        array<value_type, ChunkSize * ChunkSize> cells;
+    };
+
+    explicit sparse_grid(const value_type& defaultVal = {})
+        : m_default(defaultVal)
+    { /**/
+    }
+
+
+    // reading never allocates; cells in chunks that don't exist yet are the default value
+    const value_type& get(const coord& c) const
+    {
+        const Chunk* chunk = findChunk(c);
+        if (!chunk)
+            return m_default;
+
+        return chunk->cells[cellIx(c)];
+    }
+    const value_type& operator[](const coord& c) const      { return get(c); }
+
+    // writable access allocates the chunk if needed and grows the bounds to cover c
+    value_type& operator[](const coord& c)
+    {
+        Chunk* chunk = findChunk(c);
+        if (!chunk) [[unlikely]]
+            chunk = addChunk(c);
+
+        grow(c);
+        return chunk->cells[cellIx(c)];
+    }
+
+
+    [[nodiscard]] bool empty() const            { return m_chunks.empty(); }
+    [[nodiscard]] size_t numChunks() const      { return m_chunks.size(); }
+
+    // inclusive bounds of every cell that's been written to
+    [[nodiscard]] coord lo() const              { return m_lo; }
+    [[nodiscard]] coord hi() const              { return m_hi; }
+
+    bool isInBounds(const coord& c) const
+    {
+        return !empty() && c.x >= m_lo.x && c.y >= m_lo.y && c.x <= m_hi.x && c.y <= m_hi.y;
+    }
+
+
+    // dense iteration over the chunks that exist, in no particular order
+    void foreach_chunk(auto&& fn) const
+    {
+        for (const Chunk& chunk : m_chunks)
+            fn(chunk);
+    }
+
+    void foreach_matching(const value_type& match, auto&& fn) const
+    {
+        for (const Chunk& chunk : m_chunks)
+        {
+            auto it = begin(chunk.cells);
+            for (i32 y = 0; y < ChunkSize; ++y)
+            {
+                for (i32 x = 0; x < ChunkSize; ++x, ++it)
+                {
+                    if (*it == match)
+                        fn(chunk.origin + coord{ CoordEl(x), CoordEl(y) });
+                }
+            }
+        }
+    }
+
+    // only counts cells in chunks that exist, so counting the default value isn't very useful
+    size_t count(const value_type& match) const
+    {
+        size_t total = 0;
+        for (const Chunk& chunk : m_chunks)
+            total += ranges::count(chunk.cells, match);
+        return total;
+    }
+
+private:
+    static constexpr u32 NoChunk = numeric_limits<u32>::max();
+
+    static u64 chunkKey(const coord& c)
+    {
+        return (u64(u32(i32(c.x) >> ChunkShift)) << 32) | u32(i32(c.y) >> ChunkShift);
+    }
+    static u32 cellIx(const coord& c)
+    {
+        return u32(((i32(c.y) & ChunkMask) << ChunkShift) | (i32(c.x) & ChunkMask));
+    }
+
+    Chunk* findChunk(const coord& c) const
+    {
+        const u64 key = chunkKey(c);
+        if (key != m_lastKey)
+        {
+            auto it = m_index.find(key);
+            m_lastKey = key;
+            m_lastIx = (it == end(m_index)) ? NoChunk : it->second;
+        }
+
+        if (m_lastIx == NoChunk)
+            return nullptr;
+        return const_cast<Chunk*>(&m_chunks[m_lastIx]);
+    }
+
+    Chunk* addChunk(const coord& c)
+    {
+        const u64 key = chunkKey(c);
+        const coord origin{ CoordEl((i32(c.x) >> ChunkShift) << ChunkShift), CoordEl((i32(c.y) >> ChunkShift) << ChunkShift) };
+
+        Chunk& chunk = m_chunks.emplace_back();
+        chunk.origin = origin;
+        chunk.cells.fill(m_default);
+
+        m_lastKey = key;
+        m_lastIx = u32(m_chunks.size() - 1);
+        m_index.emplace(key, m_lastIx);
+
+        return &chunk;
+    }
+
+    void grow(const coord& c)
+    {
+        m_lo.x = min(m_lo.x, c.x);
+        m_lo.y = min(m_lo.y, c.y);
+        m_hi.x = max(m_hi.x, c.x);
+        m_hi.y = max(m_hi.y, c.y);
+    }
+
+    value_type m_default;
+    deque<Chunk> m_chunks;
+    unordered_map<u64, u32> m_index;
+
+    // the empty grid has no chunk (-1,-1) either, so this starts out as a valid cached miss
+    mutable u64 m_lastKey = chunkKey({ -1, -1 });
+    mutable u32 m_lastIx = NoChunk;
+
+    coord m_lo{ numeric_limits<CoordEl>::max(), numeric_limits<CoordEl>::max() };
+    coord m_hi{ numeric_limits<CoordEl>::min(), numeric_limits<CoordEl>::min() };
+};
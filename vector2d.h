@@ -1,32 +1,86 @@
 #pragma once
 
+#include <cstring>
+#include <limits>
 #include <ostream>
+#include <string_view>
 #include <vector>
 
+#include "mappedfile.h"
+
 
 #define CHECKED_VECTOR2Dx
 
+
+// a grid that's just a read-only view into a mapped text file. rows keep their line endings,
+// which vector2d steps over with its stride, so a multi-GB heightmap never gets copied
 template<typename T>
+struct MappedGridStorage
+{
+    static_assert(sizeof(T) == 1, "mapped grids index straight into the file bytes");
+
+    MappedFile file;
+
+    [[nodiscard]] T* data()                 { return reinterpret_cast<T*>(file.data()); }
+    [[nodiscard]] const T* data() const     { return reinterpret_cast<const T*>(file.data()); }
+    [[nodiscard]] size_t size() const       { return file.size(); }
+};
+
+
+template<typename T, typename CoordEl = i16, typename Storage = vector<T>>
 class vector2d
 {
 public:
     using value_type = T;
-    using coord = Pt2<i16>;
+    using coord = Pt2<CoordEl>;
+    using storage_type = Storage;
+
+    static constexpr bool IsMapped = !is_same_v<Storage, vector<T>>;
 
-    vector2d(u32 width, u32 height, const value_type& defaultVal = {})
+    vector2d(u32 width, u32 height, const value_type& defaultVal = {}) requires (!IsMapped)
         : m_width(width)
         , m_height(height)
-        , m_buf(width* height, defaultVal)
-    { /**/
+        , m_stride(width)
+        , m_buf(size_t(width) * height, defaultVal)
+    {
+        checkDimensions();
     }
 
-    vector2d(const stringlist& lines)
-        : m_width(u16(lines.front().length()))
-        , m_height(u16(lines.size()))
+    vector2d(const stringlist& lines) requires (!IsMapped)
+        : m_width(u32(lines.front().length()))
+        , m_height(u32(lines.size()))
+        , m_stride(m_width)
     {
-        m_buf.reserve(m_width * m_height);
+        checkDimensions();
+        m_buf.resize(size());
+
+        value_type* dst = m_buf.data();
         for (const string& line : lines)
-            ranges::copy(line, back_inserter(m_buf));
+        {
+            copyRow(dst, line.data(), min(m_width, u32(line.length())));
+            dst += m_stride;
+        }
+    }
+
+    // bulk load from raw text (eg. a whole file slurped or mapped in one go): one memcpy per row
+    explicit vector2d(string_view text) requires (!IsMapped)
+    {
+        size_t first = measureText(text);
+        m_buf.resize(size());
+
+        value_type* dst = m_buf.data();
+        const char* src = text.data() + first;
+        for (u32 y = 0; y < m_height; ++y, dst += m_width, src += m_stride)
+            copyRow(dst, src);
+
+        m_stride = m_width;
+    }
+
+    // zero-copy grid over a mapped text file
+    explicit vector2d(MappedFile&& file) requires IsMapped
+        : m_buf{ move(file) }
+    {
+        m_first = measureText(m_buf.file.view());
     }
 
 
@@ -34,16 +88,22 @@ public:
     {
         m_offset = offset;
     }
+    [[nodiscard]] const coord& offset() const { return m_offset; }
+
+    void fill(const value_type& val) requires (!IsMapped)
+    {
+        ranges::fill(m_buf, val);
+    }
 
 
     [[nodiscard]] u32 width() const { return m_width; }
     [[nodiscard]] u32 height() const { return m_height; }
-    [[nodiscard]] u32 size() const { return m_width * m_height; }
+    [[nodiscard]] size_t size() const { return size_t(m_width) * m_height; }
 
     bool isInMap(const coord& c) const
     {
         auto local = c - m_offset;
-        return (local.x < int(m_width) && local.y < int(m_height) && local.x >= 0 && local.y >= 0);
+        return (local.x < i64(m_width) && local.y < i64(m_height) && local.x >= 0 && local.y >= 0);
     }
 
     value_type& operator[](const coord& c)                  { return getLocal(c - m_offset); }
@@ -55,7 +115,7 @@ public:
         if (!isInMap(c + m_offset))
             throw "oob";
 #endif
-        return m_buf[c.x + c.y * m_width];
+        return row(u32(c.y))[c.x];
     }
     const value_type& getLocal(const coord& c) const
     {
@@ -63,53 +123,115 @@ public:
         if (!isInMap(c + m_offset))
             throw "oob";
 #endif
-        return m_buf[c.x + c.y * m_width];
+        return row(u32(c.y))[c.x];
     }
 
     coord find_first(const value_type& needle) const
     {
-        auto foundIt = ranges::find(m_buf, needle);
-        if (foundIt == end(m_buf))
-            throw "doesn't exist";
+        for (u32 y = 0; y < m_height; ++y)
+        {
+            const value_type* r = row(y);
+            const value_type* found = find(r, r + m_width, needle);
+            if (found != r + m_width)
+                return m_offset + coord{ CoordEl(found - r), CoordEl(y) };
+        }
 
-        int ix = int(distance(begin(m_buf), foundIt));
-        auto y = i16(ix / m_width);
-        auto x = i16(ix % m_width);
-        return m_offset + coord{ x, y };
+        throw "doesn't exist";
     }
 
     // o_O VC 16.11.21 can't codegen the non-hardcoded version!
     void foreach_matching(const value_type& match, auto&& fn)
     //void foreach_a(auto&& fn)
     {
-        auto it = begin(m_buf);
         for (u32 y = 0; y < m_height; ++y)
         {
+            const value_type* it = row(y);
             for (u32 x = 0; x < m_width; ++x, ++it)
             {
                 if (*it == match)
-                    fn(m_offset + coord{ coord::el_type(x), coord::el_type(y) });
+                    fn(m_offset + coord{ CoordEl(x), CoordEl(y) });
             }
         }
     }
 
 private:
-    u32 m_width;
-    u32 m_height;
+    value_type* row(u32 y)              { return m_buf.data() + m_first + size_t(y) * m_stride; }
+    const value_type* row(u32 y) const  { return m_buf.data() + m_first + size_t(y) * m_stride; }
+
+    void checkDimensions() const
+    {
+        constexpr u32 MaxSide = u32(numeric_limits<CoordEl>::max());
+        if (m_width > MaxSide || m_height > MaxSide)
+            throw "grid is too big for its coord type";
+    }
+
+    static void copyRow(value_type* dst, const char* src, u32 width)
+    {
+        if constexpr (sizeof(value_type) == 1 && is_trivially_copyable_v<value_type>)
+            memcpy(dst, src, width);
+        else
+            copy_n(src, width, dst);
+    }
+    void copyRow(value_type* dst, const char* src) const
+    {
+        copyRow(dst, src, m_width);
+    }
+
+    // works out width/height/stride of newline-separated text, returns where the first row starts
+    size_t measureText(string_view text)
+    {
+        size_t first = 0;
+        if (text.starts_with("\xEF\xBB\xBF"))
+            first = 3;
+
+        // no text, no rows
+        if (first == text.size())
+        {
+            m_width = m_height = m_stride = 0;
+            return first;
+        }
+
+        size_t eol = text.find('\n', first);
+        if (eol == string_view::npos)
+            eol = text.size();
+
+        size_t eolLen = 1;
+        size_t width = eol - first;
+        if (width > 0 && text[eol - 1] == '\r')
+        {
+            --width;
+            ++eolLen;
+        }
+
+        m_width = u32(width);
+        m_stride = u32(width + eolLen);
+        m_height = u32((text.size() - first + eolLen) / m_stride);
+        checkDimensions();
+
+        return first;
+    }
+
+    u32 m_width = 0;
+    u32 m_height = 0;
+    u32 m_stride = 0;
+    size_t m_first = 0;
     coord m_offset{0,0};
-    vector<value_type> m_buf;
+    storage_type m_buf;
 };
 
+template<typename T, typename CoordEl = i16>
+using mapped_vector2d = vector2d<T, CoordEl, MappedGridStorage<T>>;
+
 
-inline ostream& operator<<(ostream& os, const vector2d<char> map)
+template<typename CoordEl, typename Storage>
+inline ostream& operator<<(ostream& os, const vector2d<char, CoordEl, Storage>& map)
 {
-    using coord = decltype(map)::coord;
-    using ctype = coord::el_type;
+    using coord = typename vector2d<char, CoordEl, Storage>::coord;
 
     for (u32 y=0; y<map.height(); ++y)
     {
         for (u32 x=0; x<map.width(); ++x)
-            os << map.getLocal(coord{ ctype(x), ctype(y) });
+            os << map.getLocal(coord{ CoordEl(x), CoordEl(y) });
 
         os << "\n";
     }
@@ -117,4 +239,3 @@ inline ostream& operator<<(ostream& os, const vector2d<char> map)
     os << flush;
     return os;
 }
-
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <vector>
+
+#include "pt3.h"
+
+
+// shared indexing for the 3d grids: the region [lo,hi] gets a one cell border all the way round,
+// so every cell in the region can look at its 6 neighbours without a bounds check. neighbours are
+// just fixed offsets into the buffer, in the same order as NeighbourDirs
+template<typename CoordEl = i16>
+class voxel_layout
+{
+public:
+    using coord = Pt3<CoordEl>;
+    using index = u32;
+
+    static constexpr coord NeighbourDirs[] = { {1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,1}, {0,0,-1} };
+
+    voxel_layout(const coord& lo, const coord& hi)
+        : m_origin(CoordEl(lo.x - 1), CoordEl(lo.y - 1), CoordEl(lo.z - 1))
+        , m_size(checkedSize(lo, hi))
+    {
+        const i32 strideY = i32(m_size.x);
+        const i32 strideZ = i32(m_size.x * m_size.y);
+        m_neighbours = { 1, -1, strideY, -strideY, strideZ, -strideZ };
+    }
+
+    [[nodiscard]] size_t size() const       { return size_t(m_size.x) * m_size.y * m_size.z; }
+
+    // the region we were asked for, ie. not including the border
+    [[nodiscard]] coord lo() const          { return { CoordEl(m_origin.x + 1), CoordEl(m_origin.y + 1), CoordEl(m_origin.z + 1) }; }
+    [[nodiscard]] coord hi() const          { return { CoordEl(m_origin.x + m_size.x - 2), CoordEl(m_origin.y + m_size.y - 2), CoordEl(m_origin.z + m_size.z - 2) }; }
+
+    // true for the region and its border
+    bool isInGrid(const coord& c) const
+    {
+        return c.x >= m_origin.x && c.y >= m_origin.y && c.z >= m_origin.z
+            && u32(c.x - m_origin.x) < m_size.x && u32(c.y - m_origin.y) < m_size.y && u32(c.z - m_origin.z) < m_size.z;
+    }
+
+    index indexOf(const coord& c) const
+    {
+        return index(c.x - m_origin.x) + index(c.y - m_origin.y) * m_size.x + index(c.z - m_origin.z) * m_size.x * m_size.y;
+    }
+
+    const array<i32, 6>& neighbourStrides() const  { return m_neighbours; }
+    index neighbour(index ix, u32 dir) const        { return index(i32(ix) + m_neighbours[dir]); }
+
+    bool isBorder(index ix) const
+    {
+        const u32 x = ix % m_size.x;
+        const u32 y = (ix / m_size.x) % m_size.y;
+        const u32 z = ix / (m_size.x * m_size.y);
+        return x == 0 || y == 0 || z == 0 || x + 1 == m_size.x || y + 1 == m_size.y || z + 1 == m_size.z;
+    }
+
+private:
+    // the region plus a cell of border each side, as long as it's a real box that can be indexed
+    static Pt3<u32> checkedSize(const coord& lo, const coord& hi)
+    {
+        if (hi.x < lo.x || hi.y < lo.y || hi.z < lo.z)
+            throw "voxel region is inside out";
+
+        auto hasBorder = [](CoordEl l, CoordEl h)
+        {
+            return l > numeric_limits<CoordEl>::min() && h < numeric_limits<CoordEl>::max();
+        };
+        if (!hasBorder(lo.x, hi.x) || !hasBorder(lo.y, hi.y) || !hasBorder(lo.z, hi.z))
+            throw "voxel region border is too big for its coord type";
+
+        const Pt3<u32> size(u32(i64(hi.x) - lo.x + 3), u32(i64(hi.y) - lo.y + 3), u32(i64(hi.z) - lo.z + 3));
+        if (u64(size.x) * size.y * size.z > numeric_limits<u32>::max())
+            throw "voxel region is too big to index";
+
+        return size;
+    }
+
+    coord m_origin;
+    Pt3<u32> m_size;
+    array<i32, 6> m_neighbours;
+};
+
+
+template<typename T, typename CoordEl = i16>
+class vector3d : public voxel_layout<CoordEl>
+{
+public:
+    using value_type = T;
+    using layout = voxel_layout<CoordEl>;
+    using typename layout::coord;
+    using typename layout::index;
+
+    vector3d(const coord& lo, const coord& hi, const value_type& defaultVal = {})
+        : vector3d(lo, hi, defaultVal, defaultVal)
+    { /**/
+    }
+
+    // the border gets its own value so eg. a flood fill can treat it as already visited
+    vector3d(const coord& lo, const coord& hi, const value_type& defaultVal, const value_type& borderVal)
+        : layout(lo, hi)
+        , m_buf(layout::size(), borderVal)
+    {
+        for (CoordEl z = lo.z; z <= hi.z; ++z)
+        {
+            for (CoordEl y = lo.y; y <= hi.y; ++y)
+            {
+                auto itRow = begin(m_buf) + layout::indexOf({ lo.x, y, z });
+                fill(itRow, itRow + (hi.x - lo.x + 1), defaultVal);
+            }
+        }
+    }
+
+    value_type& operator[](const coord& c)              { return m_buf[layout::indexOf(c)]; }
+    const value_type& operator[](const coord& c) const  { return m_buf[layout::indexOf(c)]; }
+
+    value_type& operator[](index ix)                    { return m_buf[ix]; }
+    const value_type& operator[](index ix) const        { return m_buf[ix]; }
+
+    // cells outside the grid and its border are fine too, they just read as `outside`
+    const value_type& get(const coord& c, const value_type& outside) const
+    {
+        if (!layout::isInGrid(c))
+            return outside;
+        return m_buf[layout::indexOf(c)];
+    }
+
+    [[nodiscard]] value_type* data()                    { return m_buf.data(); }
+    [[nodiscard]] const value_type* data() const        { return m_buf.data(); }
+
+private:
+    vector<value_type> m_buf;
+};
+
+
+// one bit per voxel, same layout as vector3d
+template<typename CoordEl = i16>
+class bitvector3d : public voxel_layout<CoordEl>
+{
+public:
+    using layout = voxel_layout<CoordEl>;
+    using typename layout::coord;
+    using typename layout::index;
+
+    bitvector3d(const coord& lo, const coord& hi)
+        : layout(lo, hi)
+        , m_bits((layout::size() + 63) / 64, 0)
+    { /**/
+    }
+
+    bool test(index ix) const       { return (m_bits[ix >> 6] >> (ix & 63)) & 1; }
+    void set(index ix)              { m_bits[ix >> 6] |= (u64(1) << (ix & 63)); }
+    void reset(index ix)            { m_bits[ix >> 6] &= ~(u64(1) << (ix & 63)); }
+
+    bool test(const coord& c) const { return test(layout::indexOf(c)); }
+    void set(const coord& c)        { set(layout::indexOf(c)); }
+    void reset(const coord& c)      { reset(layout::indexOf(c)); }
+
+    // how many of ix's 6 neighbours are set
+    u32 countNeighbours(index ix) const
+    {
+        u32 n = 0;
+        for (i32 stride : layout::neighbourStrides())
+            n += test(index(i32(ix) + stride));
+        return n;
+    }
+
+    size_t count() const
+    {
+        size_t n = 0;
+        for (u64 word : m_bits)
+            n += popcount(word);
+        return n;
+    }
+
+private:
+    vector<u64> m_bits;
+};